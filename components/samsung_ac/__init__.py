@@ -10,7 +10,7 @@ from esphome.core import (
 CODEOWNERS = ["matthias882", "lanwin"]
 DEPENDENCIES = ["uart"]
 AUTO_LOAD = ["sensor", "switch", "select", "number", "climate"]
-MULTI_CONF = False
+MULTI_CONF = True
 
 CONF_SAMSUNG_AC_ID = "samsung_ac_id"
 
@@ -19,6 +19,7 @@ Samsung_AC = samsung_ac.class_(
     "Samsung_AC", cg.PollingComponent, uart.UARTDevice
 )
 Samsung_AC_Device = samsung_ac.class_("Samsung_AC_Device")
+Samsung_AC_Group = samsung_ac.class_("Samsung_AC_Group")
 Samsung_AC_Switch = samsung_ac.class_("Samsung_AC_Switch", switch.Switch)
 Samsung_AC_Mode_Select = samsung_ac.class_(
     "Samsung_AC_Mode_Select", select.Select)
@@ -61,6 +62,9 @@ CONF_DEVICE_CUSTOM_SWITCH = "switch"
 CONF_DEVICE_CUSTOM_SWITCH_MESSAGE = "message"
 CONF_DEVICE_CUSTOM_NUMBER = "number"
 CONF_DEVICE_CUSTOM_NUMBER_MESSAGE = "message"
+CONF_DEVICE_POLL = "poll"
+CONF_DEVICE_POLL_MESSAGE = "message"
+CONF_DEVICE_POLL_INTERVAL = "interval"
 CONF_DEVICE_CUSTOMCLIMATE = "climate"
 CONF_DEVICE_CUSTOMCLIMATE_status_addr = "status_addr"
 CONF_DEVICE_CUSTOMCLIMATE_set_addr = "set_addr"
@@ -139,6 +143,11 @@ CUSTOM_SENSOR_SCHEMA = sensor.sensor_schema().extend({
     cv.Required(CONF_DEVICE_CUSTOM_MESSAGE): cv.hex_int,
 })
 
+POLL_SCHEMA = cv.Schema({
+    cv.Required(CONF_DEVICE_POLL_MESSAGE): cv.hex_int,
+    cv.Optional(CONF_DEVICE_POLL_INTERVAL, default="60s"): cv.positive_time_period_milliseconds,
+})
+
 CUSTOM_SWITCH_SCHEMA = switch.switch_schema(Samsung_AC_Switch).extend({
     cv.Required(CONF_DEVICE_CUSTOM_SWITCH_MESSAGE): cv.hex_int,
 })
@@ -234,6 +243,7 @@ DEVICE_SCHEMA = (
             cv.Optional(CONF_DEVICE_CUSTOM, default=[]): cv.ensure_list(CUSTOM_SENSOR_SCHEMA),
             cv.Optional(CONF_DEVICE_CUSTOM_SWITCH, default=[]): cv.ensure_list(CUSTOM_SWITCH_SCHEMA),
             cv.Optional(CONF_DEVICE_CUSTOM_NUMBER, default=[]): cv.ensure_list(CUSTOM_NUMBER_SCHEMA),
+            cv.Optional(CONF_DEVICE_POLL, default=[]): cv.ensure_list(POLL_SCHEMA),
 
             # keep CUSTOM_SENSOR_KEYS in sync with these
             cv.Optional(CONF_DEVICE_WATER_TEMPERATURE): temperature_sensor_schema(0x4237),
@@ -262,6 +272,30 @@ CUSTOM_SENSOR_KEYS = [
 
 CONF_DEVICES = "devices"
 
+CONF_GROUPS = "groups"
+CONF_GROUP_ID = "samsung_ac_group_id"
+CONF_GROUP_DEVICES = "devices"
+CONF_GROUP_BROADCAST_ADDRESS = "broadcast_address"
+
+MODE_OPTIONS = ["Auto", "Cool", "Dry", "Fan", "Heat"]
+
+GROUP_SCHEMA = cv.Schema(
+    {
+        cv.GenerateID(CONF_GROUP_ID): cv.declare_id(Samsung_AC_Group),
+        cv.Required(CONF_NAME): cv.string,
+        # addresses of the members, all configured indoor units when empty
+        cv.Optional(CONF_GROUP_DEVICES, default=[]): cv.ensure_list(cv.string),
+        cv.Optional(CONF_GROUP_BROADCAST_ADDRESS): cv.string,
+        cv.Optional(CONF_DEVICE_POWER): switch.switch_schema(Samsung_AC_Switch),
+        cv.Optional(CONF_DEVICE_TARGET_TEMPERATURE): number.number_schema(
+            Samsung_AC_Number,
+            unit_of_measurement=UNIT_CELSIUS,
+            device_class=DEVICE_CLASS_TEMPERATURE,
+        ),
+        cv.Optional(CONF_DEVICE_MODE): SELECT_MODE_SCHEMA,
+    }
+)
+
 
 CONF_DEBUG_MQTT_HOST = "debug_mqtt_host"
 CONF_DEBUG_MQTT_PORT = "debug_mqtt_port"
@@ -271,12 +305,37 @@ CONF_DEBUG_MQTT_PASSWORD = "debug_mqtt_password"
 CONF_DEBUG_LOG_MESSAGES = "debug_log_messages"
 CONF_DEBUG_LOG_MESSAGES_RAW = "debug_log_messages_raw"
 
+CONF_MAX_LOOP_TIME = "max_loop_time"
+CONF_SKIP_DUPLICATE_FRAMES = "skip_duplicate_frames"
+CONF_DUPLICATE_FRAME_WINDOW = "duplicate_frame_window"
+CONF_FILTER_UNCONFIGURED_DEVICES = "filter_unconfigured_devices"
+CONF_DISCOVERY_SAMPLE_RATE = "discovery_sample_rate"
+CONF_RX_TASK = "rx_task"
+CONF_RX_TASK_CORE = "rx_task_core"
+CONF_TX_IDLE_GAP = "tx_idle_gap"
+CONF_TX_MAX_BACKOFF = "tx_max_backoff"
+CONF_TX_ECHO_CHECK = "tx_echo_check"
+CONF_TX_STARVATION_LIMIT = "tx_starvation_limit"
+# one queue depth and one wait time sensor per transmit priority, in priority order
+TX_PRIORITIES = ["control", "retry", "poll"]
+CONF_TX_QUEUE_DEPTH = "tx_{}_queue_depth"
+CONF_TX_WAIT_TIME = "tx_{}_wait_time"
+CONF_REQUEST_SETTLE_WINDOW = "request_settle_window"
+CONF_REQUEST_TIMEOUT = "request_timeout"
+CONF_REQUEST_RETRIES = "request_retries"
+
 CONF_debug_number = "debug_number"
 CONF_debug_number_SOURCE = "source"
 CONF_debug_number_MIN = "min"
 CONF_debug_number_MAX = "max"
 
-CONFIG_SCHEMA = (
+def validate_rx_task(config):
+    if config[CONF_RX_TASK] and not CORE.is_esp32:
+        raise cv.Invalid(f"{CONF_RX_TASK} is only supported on ESP32")
+    return config
+
+
+CONFIG_SCHEMA = cv.All(
     cv.Schema(
         {
             cv.GenerateID(): cv.declare_id(Samsung_AC),
@@ -287,8 +346,34 @@ CONFIG_SCHEMA = (
             cv.Optional(CONF_DEBUG_MQTT_PASSWORD, default=""): cv.string,
             cv.Optional(CONF_DEBUG_LOG_MESSAGES, default=False): cv.boolean,
             cv.Optional(CONF_DEBUG_LOG_MESSAGES_RAW, default=False): cv.boolean,
+            cv.Optional(CONF_MAX_LOOP_TIME, default="5ms"): cv.positive_time_period_milliseconds,
+            cv.Optional(CONF_SKIP_DUPLICATE_FRAMES, default=False): cv.boolean,
+            cv.Optional(CONF_DUPLICATE_FRAME_WINDOW, default="30s"): cv.positive_time_period_milliseconds,
+            cv.Optional(CONF_FILTER_UNCONFIGURED_DEVICES, default=False): cv.boolean,
+            cv.Optional(CONF_DISCOVERY_SAMPLE_RATE, default=32): cv.int_range(min=0, max=65535),
+            cv.Optional(CONF_RX_TASK, default=False): cv.boolean,
+            cv.Optional(CONF_RX_TASK_CORE, default=-1): cv.int_range(min=-1, max=1),
+            cv.Optional(CONF_TX_IDLE_GAP, default="10ms"): cv.positive_time_period_milliseconds,
+            cv.Optional(CONF_TX_MAX_BACKOFF, default="20ms"): cv.positive_time_period_milliseconds,
+            cv.Optional(CONF_TX_ECHO_CHECK, default=False): cv.boolean,
+            cv.Optional(CONF_TX_STARVATION_LIMIT, default="2s"): cv.positive_time_period_milliseconds,
+            **{cv.Optional(CONF_TX_QUEUE_DEPTH.format(p)): sensor.sensor_schema(
+                accuracy_decimals=0,
+                state_class=STATE_CLASS_MEASUREMENT,
+                entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+            ) for p in TX_PRIORITIES},
+            **{cv.Optional(CONF_TX_WAIT_TIME.format(p)): sensor.sensor_schema(
+                unit_of_measurement=UNIT_MILLISECOND,
+                accuracy_decimals=0,
+                state_class=STATE_CLASS_MEASUREMENT,
+                entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+            ) for p in TX_PRIORITIES},
+            cv.Optional(CONF_REQUEST_SETTLE_WINDOW, default="100ms"): cv.positive_time_period_milliseconds,
+            cv.Optional(CONF_REQUEST_TIMEOUT, default="1s"): cv.positive_time_period_milliseconds,
+            cv.Optional(CONF_REQUEST_RETRIES, default=3): cv.int_range(min=0, max=3),
             cv.Optional(CONF_CAPABILITIES): CAPABILITIES_SCHEMA,
             cv.Required(CONF_DEVICES): cv.ensure_list(DEVICE_SCHEMA),
+            cv.Optional(CONF_GROUPS, default=[]): cv.ensure_list(GROUP_SCHEMA),
             cv.Optional(CONF_debug_number) : cv.ensure_list(number.NUMBER_SCHEMA.extend({
                 cv.GenerateID(): cv.declare_id(Samsung_AC_NumberDebug),
                 cv.Optional(CONF_debug_number_SOURCE, default=""): cv.string,
@@ -298,7 +383,8 @@ CONFIG_SCHEMA = (
         }
     )
     .extend(uart.UART_DEVICE_SCHEMA)
-    .extend(cv.polling_component_schema("30s"))
+    .extend(cv.polling_component_schema("30s")),
+    validate_rx_task,
 )
 
 
@@ -365,8 +451,7 @@ async def to_code(config):
 
         if CONF_DEVICE_MODE in device:
             conf = device[CONF_DEVICE_MODE]
-            values = ["Auto", "Cool", "Dry", "Fan", "Heat"]
-            sel = await select.new_select(conf, options=values)
+            sel = await select.new_select(conf, options=MODE_OPTIONS)
             cg.add(var_dev.set_mode_select(sel))
 
 
@@ -394,6 +479,10 @@ async def to_code(config):
                 cg.add(var_dev.add_custom_number(
                     cust_number[CONF_DEVICE_CUSTOM_NUMBER_MESSAGE], number_device, multiply_value))
 
+        for poll in device[CONF_DEVICE_POLL]:
+            cg.add(var_dev.add_poll(
+                poll[CONF_DEVICE_POLL_MESSAGE], poll[CONF_DEVICE_POLL_INTERVAL]))
+
         for key in CUSTOM_SENSOR_KEYS:
             if key in device:
                 conf = device[key]
@@ -448,6 +537,29 @@ async def to_code(config):
 
         cg.add(var.register_device(var_dev))
 
+    for group in config[CONF_GROUPS]:
+        var_group = cg.new_Pvariable(group[CONF_GROUP_ID], group[CONF_NAME], var)
+        for address in group[CONF_GROUP_DEVICES]:
+            cg.add(var_group.add_device_address(address))
+
+        if CONF_GROUP_BROADCAST_ADDRESS in group:
+            cg.add(var_group.set_broadcast_address(group[CONF_GROUP_BROADCAST_ADDRESS]))
+
+        if CONF_DEVICE_POWER in group:
+            switch_device = await switch.new_switch(group[CONF_DEVICE_POWER])
+            cg.add(var_group.set_power_switch(switch_device))
+
+        if CONF_DEVICE_TARGET_TEMPERATURE in group:
+            number_device = await number.new_number(group[CONF_DEVICE_TARGET_TEMPERATURE],
+                                                    min_value=16, max_value=30, step=1)
+            cg.add(var_group.set_target_temperature_number(number_device))
+
+        if CONF_DEVICE_MODE in group:
+            sel = await select.new_select(group[CONF_DEVICE_MODE], options=MODE_OPTIONS)
+            cg.add(var_group.set_mode_select(sel))
+
+        cg.add(var.register_group(var_group))
+
     cg.add(var.set_debug_mqtt(config[CONF_DEBUG_MQTT_HOST], config[CONF_DEBUG_MQTT_PORT],
            config[CONF_DEBUG_MQTT_USERNAME], config[CONF_DEBUG_MQTT_PASSWORD]))
 
@@ -457,6 +569,30 @@ async def to_code(config):
     if (CONF_DEBUG_LOG_MESSAGES_RAW in config):
         cg.add(var.set_debug_log_messages_raw(
             config[CONF_DEBUG_LOG_MESSAGES_RAW]))
+
+    cg.add(var.set_max_loop_time(config[CONF_MAX_LOOP_TIME]))
+    cg.add(var.set_skip_duplicate_frames(config[CONF_SKIP_DUPLICATE_FRAMES]))
+    cg.add(var.set_duplicate_frame_window(config[CONF_DUPLICATE_FRAME_WINDOW]))
+    cg.add(var.set_filter_unconfigured_devices(config[CONF_FILTER_UNCONFIGURED_DEVICES]))
+    cg.add(var.set_discovery_sample_rate(config[CONF_DISCOVERY_SAMPLE_RATE]))
+    cg.add(var.set_rx_task(config[CONF_RX_TASK], config[CONF_RX_TASK_CORE]))
+    cg.add(var.set_tx_idle_gap(config[CONF_TX_IDLE_GAP]))
+    cg.add(var.set_tx_max_backoff(config[CONF_TX_MAX_BACKOFF]))
+    cg.add(var.set_tx_echo_check(config[CONF_TX_ECHO_CHECK]))
+    cg.add(var.set_tx_starvation_limit(config[CONF_TX_STARVATION_LIMIT]))
+    for index, priority in enumerate(TX_PRIORITIES):
+        depth = None
+        wait_time = None
+        if CONF_TX_QUEUE_DEPTH.format(priority) in config:
+            depth = await sensor.new_sensor(config[CONF_TX_QUEUE_DEPTH.format(priority)])
+        if CONF_TX_WAIT_TIME.format(priority) in config:
+            wait_time = await sensor.new_sensor(config[CONF_TX_WAIT_TIME.format(priority)])
+        if depth is not None or wait_time is not None:
+            cg.add(var.set_tx_queue_sensors(index, depth if depth is not None else cg.nullptr,
+                                            wait_time if wait_time is not None else cg.nullptr))
+    cg.add(var.set_request_settle_window(config[CONF_REQUEST_SETTLE_WINDOW]))
+    cg.add(var.set_request_timeout(config[CONF_REQUEST_TIMEOUT]))
+    cg.add(var.set_request_retries(config[CONF_REQUEST_RETRIES]))
     
     if CONF_debug_number in config:
         for conf in config[CONF_debug_number]:
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <map>
+#include <queue>
+#include <string>
+#include <vector>
+#include "protocol_nasa.h"
+#include "protocol_non_nasa.h"
+#include "duplicate_filter.h"
+#include "retransmit_table.h"
+#include "poll_table.h"
+
+namespace esphome
+{
+    namespace samsung_ac
+    {
+        // Holds all protocol state of one bus. Each bus owns its own context, so
+        // decoding does not depend on globals and several decoders can run at the
+        // same time (e.g. multiple buses or parallel replays of captured data).
+        struct DecoderContext
+        {
+            DecoderContext()
+            {
+                packet.messages.reserve(MAX_MESSAGES_PER_PACKET);
+            }
+
+            Packet packet;               // last decoded NASA packet
+            // frame of the last NASA packet, only valid while it is processed
+            const uint8_t *frame = nullptr;
+            size_t frame_size = 0;
+            NonNasaDataPacket nonpacket; // last decoded NonNASA packet
+
+            // set per hub, so every bus can be logged on its own
+            bool debug_log_packets = false;
+            bool debug_log_raw_bytes = false;
+
+            // repeated notifications are dropped before their messages are decoded
+            DuplicateFrameFilter duplicates;
+
+            // When enabled, NASA frames from and to devices which are not configured are
+            // dropped right after the header. Every discovery_sample_rate-th of them is
+            // processed anyway so new devices are still discovered (0 never does).
+            bool filter_unconfigured = false;
+            uint16_t discovery_sample_rate = 32;
+            std::vector<PackedAddress> configured_addresses; // sorted
+            uint32_t filtered_frames = 0;
+
+            // last state reported by every NonNASA indoor unit, requests are based on it
+            std::map<PackedAddress, NonNasaCommand20> last_command20s;
+
+            // NASA packet numbers are counted per bus
+            uint8_t packet_counter = 0;
+            // NASA control changes are collected per device for this long (0 sends them right away)
+            uint32_t request_settle_window = 100;
+            std::map<PackedAddress, PendingNasaRequest> pending_requests;
+            // NASA messages which are read actively
+            PollTable polls;
+            // sent NASA requests which are not acknowledged yet
+            RetransmitTable requests;
+            // NonNASA requests wait for the next send window of the bus
+            std::queue<NonNasaRequest> nonnasa_requests;
+            bool nonnasa_window_open = false;
+            uint32_t nonnasa_window_start = 0; // when the trigger frame was received
+            uint32_t nonnasa_last_send = 0;
+        };
+    } // namespace samsung_ac
+} // namespace esphome
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include "protocol.h"
+
+namespace esphome
+{
+    namespace samsung_ac
+    {
+        // Remembers the last frame of every kind (same source, same header hash and
+        // length) and reports a frame as duplicate when it carries the same content
+        // as the last processed one of its kind and the window did not pass yet.
+        // Only the last frame of a kind is compared, so a value which changes and
+        // changes back is never swallowed.
+        class DuplicateFrameFilter
+        {
+        public:
+            static const size_t ENTRIES = 32;
+
+            void set_enabled(bool enabled)
+            {
+                enabled_ = enabled;
+                clear();
+            }
+
+            bool is_enabled() const { return enabled_; }
+
+            void set_window(uint32_t window_ms)
+            {
+                window_ms_ = window_ms;
+            }
+
+            uint32_t get_window() const { return window_ms_; }
+
+            // Returns true when the frame should be dropped. Otherwise the frame is
+            // remembered as the last processed one of its kind.
+            bool check(PackedAddress source, uint32_t header_hash, uint16_t length, uint16_t crc, uint32_t now)
+            {
+                if (!enabled_ || window_ms_ == 0)
+                    return false;
+
+                Entry *slot = nullptr;
+                for (size_t i = 0; i < ENTRIES; i++)
+                {
+                    Entry &entry = entries_[i];
+                    if (entry.used && entry.source == source && entry.header_hash == header_hash && entry.length == length)
+                    {
+                        if (entry.crc == crc && now - entry.processed < window_ms_)
+                        {
+                            dropped_++;
+                            return true;
+                        }
+                        slot = &entry;
+                        break;
+                    }
+
+                    // prefer an unused entry, otherwise the one processed longest ago
+                    if (slot == nullptr || (slot->used && (!entry.used || now - entry.processed > now - slot->processed)))
+                        slot = &entry;
+                }
+
+                slot->used = true;
+                slot->source = source;
+                slot->header_hash = header_hash;
+                slot->length = length;
+                slot->crc = crc;
+                slot->processed = now;
+                return false;
+            }
+
+            void clear()
+            {
+                for (size_t i = 0; i < ENTRIES; i++)
+                    entries_[i].used = false;
+            }
+
+            uint32_t get_dropped() const { return dropped_; }
+
+        protected:
+            struct Entry
+            {
+                PackedAddress source;
+                uint32_t header_hash;
+                uint32_t processed;
+                uint16_t length;
+                uint16_t crc;
+                bool used{false};
+            };
+
+            Entry entries_[ENTRIES];
+            bool enabled_{false};
+            uint32_t window_ms_{30000};
+            uint32_t dropped_{0};
+        };
+    } // namespace samsung_ac
+} // namespace esphome
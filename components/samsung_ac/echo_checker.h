@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <algorithm>
+#include "protocol.h"
+
+namespace esphome
+{
+    namespace samsung_ac
+    {
+        // Compares the bytes received while we send with the frame we sent, for RS485
+        // adapters which echo our own bytes back. Matching bytes are swallowed so the
+        // echo never reaches the framer, a byte which differs means somebody else was
+        // sending at the same time. The sender arms the checker before writing and takes
+        // the result afterwards; the receiving side may run in another task, the state
+        // is handed over atomically.
+        class EchoChecker
+        {
+        public:
+            enum class Result : uint8_t
+            {
+                Idle,
+                Pending,
+                Match,
+                Mismatch,
+                Missing // not (completely) received in time
+            };
+
+            void arm(const uint8_t *data, size_t size)
+            {
+                // no frame is longer, so arming never allocates
+                size_ = size < MAX_PACKET_SIZE ? size : MAX_PACKET_SIZE;
+                std::copy(data, data + size_, expected_);
+                position_ = 0;
+                result_.store(size_ > 0 ? Result::Pending : Result::Match, std::memory_order_release);
+            }
+
+            bool pending() const { return result_.load(std::memory_order_acquire) == Result::Pending; }
+
+            // Called with every received byte, returns true when it was part of the echo.
+            bool feed(uint8_t c)
+            {
+                if (result_.load(std::memory_order_acquire) != Result::Pending)
+                    return false;
+
+                if (c != expected_[position_])
+                {
+                    resolve(Result::Mismatch);
+                    return false;
+                }
+
+                if (++position_ == size_)
+                    resolve(Result::Match);
+                return true;
+            }
+
+            // Ends the check, a check still pending counts as missing.
+            Result take()
+            {
+                // when it is not pending anymore, result receives what the receiving side decided
+                Result result = Result::Pending;
+                if (result_.compare_exchange_strong(result, Result::Idle, std::memory_order_acq_rel))
+                    result = Result::Missing;
+                else
+                    result_.store(Result::Idle, std::memory_order_release);
+
+                if (result == Result::Match)
+                    matched_++;
+                else if (result == Result::Mismatch)
+                    mismatched_++;
+                else if (result == Result::Missing)
+                    missing_++;
+                return result;
+            }
+
+            uint32_t get_matched() const { return matched_; }
+            uint32_t get_mismatched() const { return mismatched_; }
+            uint32_t get_missing() const { return missing_; }
+
+        protected:
+            void resolve(Result result)
+            {
+                Result expected = Result::Pending;
+                result_.compare_exchange_strong(expected, result, std::memory_order_acq_rel);
+            }
+
+            uint8_t expected_[MAX_PACKET_SIZE];
+            size_t size_{0};
+            size_t position_{0};
+            std::atomic<Result> result_{Result::Idle};
+
+            uint32_t matched_{0};
+            uint32_t mismatched_{0};
+            uint32_t missing_{0};
+        };
+    } // namespace samsung_ac
+} // namespace esphome
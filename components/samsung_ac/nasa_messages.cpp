@@ -0,0 +1,232 @@
+#include "esphome/core/hal.h"
+#include "nasa_messages.h"
+
+namespace esphome
+{
+    namespace samsung_ac
+    {
+        // Names are only needed for logging, keep them out of RAM.
+        static const char NAME_4000[] PROGMEM = "ENUM_in_operation_power";
+        static const char NAME_4001[] PROGMEM = "ENUM_in_operation_mode";
+        static const char NAME_4002[] PROGMEM = "ENUM_in_operation_mode_real";
+        static const char NAME_4003[] PROGMEM = "ENUM_IN_OPERATION_VENT_POWER";
+        static const char NAME_4004[] PROGMEM = "ENUM_IN_OPERATION_VENT_MODE";
+        static const char NAME_4006[] PROGMEM = "ENUM_in_fan_mode";
+        static const char NAME_4007[] PROGMEM = "ENUM_in_fan_mode_real";
+        static const char NAME_4008[] PROGMEM = "ENUM_in_fan_vent_mode";
+        static const char NAME_4011[] PROGMEM = "ENUM_in_louver_hl_swing";
+        static const char NAME_4012[] PROGMEM = "ENUM_in_louver_hl_part_swing";
+        static const char NAME_4038[] PROGMEM = "ENUM_in_state_humidity_percent";
+        static const char NAME_4060[] PROGMEM = "ENUM_in_alt_mode";
+        static const char NAME_4065[] PROGMEM = "ENUM_IN_WATER_HEATER_POWER";
+        static const char NAME_407E[] PROGMEM = "ENUM_in_louver_lr_swing";
+        static const char NAME_4201[] PROGMEM = "VAR_in_temp_target_f";
+        static const char NAME_4203[] PROGMEM = "VAR_in_temp_room_f";
+        static const char NAME_4205[] PROGMEM = "VAR_in_temp_eva_in_f";
+        static const char NAME_4206[] PROGMEM = "VAR_in_temp_eva_out_f";
+        static const char NAME_4211[] PROGMEM = "VAR_in_capacity_request";
+        static const char NAME_4237[] PROGMEM = "VAR_in_temp_water_tank_f";
+        static const char NAME_4260[] PROGMEM = "VAR_IN_FSV_3021";
+        static const char NAME_4261[] PROGMEM = "VAR_IN_FSV_3022";
+        static const char NAME_4262[] PROGMEM = "VAR_IN_FSV_3023";
+        static const char NAME_8001[] PROGMEM = "ENUM_out_operation_odu_mode";
+        static const char NAME_8003[] PROGMEM = "ENUM_out_operation_heatcool";
+        static const char NAME_801A[] PROGMEM = "ENUM_out_load_4way";
+        static const char NAME_8204[] PROGMEM = "VAR_out_sensor_airout";
+        static const char NAME_8235[] PROGMEM = "VAR_out_error_code";
+        static const char NAME_8261[] PROGMEM = "VAR_OUT_SENSOR_PIPEIN3";
+        static const char NAME_8262[] PROGMEM = "VAR_OUT_SENSOR_PIPEIN4";
+        static const char NAME_8263[] PROGMEM = "VAR_OUT_SENSOR_PIPEIN5";
+        static const char NAME_8264[] PROGMEM = "VAR_OUT_SENSOR_PIPEOUT1";
+        static const char NAME_8265[] PROGMEM = "VAR_OUT_SENSOR_PIPEOUT2";
+        static const char NAME_8266[] PROGMEM = "VAR_OUT_SENSOR_PIPEOUT3";
+        static const char NAME_8267[] PROGMEM = "VAR_OUT_SENSOR_PIPEOUT4";
+        static const char NAME_8268[] PROGMEM = "VAR_OUT_SENSOR_PIPEOUT5";
+        static const char NAME_8274[] PROGMEM = "VAR_out_control_order_cfreq_comp2";
+        static const char NAME_8275[] PROGMEM = "VAR_out_control_target_cfreq_comp2";
+        static const char NAME_8280[] PROGMEM = "VAR_out_sensor_top1";
+        static const char NAME_82BC[] PROGMEM = "VAR_OUT_PROJECT_CODE";
+        static const char NAME_82DB[] PROGMEM = "VAR_OUT_PHASE_CURRENT";
+        static const char NAME_82E3[] PROGMEM = "VAR_OUT_PRODUCT_OPTION_CAPA";
+        static const char NAME_8411[] PROGMEM = "NASA_OUTDOOR_CONTROL_WATTMETER_1UNIT";
+        static const char NAME_8413[] PROGMEM = "LVAR_OUT_CONTROL_WATTMETER_1W_1MIN_SUM";
+        static const char NAME_8414[] PROGMEM = "LVAR_OUT_CONTROL_WATTMETER_ALL_UNIT_ACCUM";
+        static const char NAME_8415[] PROGMEM = "NASA_OUTDOOR_CONTROL_WATTMETER_TOTAL_SUM";
+        static const char NAME_8416[] PROGMEM = "NASA_OUTDOOR_CONTROL_WATTMETER_TOTAL_SUM_ACCUM";
+        static const char NAME_8426[] PROGMEM = "LVAR_OUT_ACTUAL_PRODUCED_ENERGY";
+        static const char NAME_8427[] PROGMEM = "LVAR_OUT_TOTAL_PRODUCED_ENERGY";
+
+        // Sorted by message number, find_message_info does a binary search.
+        static constexpr MessageInfo message_registry[] PROGMEM = {
+            {0x4000, Enum, false, MessageScale::None, MessageUnit::None, MessageHandler::None, NAME_4000},
+            {0x4001, Enum, false, MessageScale::None, MessageUnit::None, MessageHandler::OperationMode, NAME_4001},
+            {0x4002, Enum, false, MessageScale::None, MessageUnit::None, MessageHandler::None, NAME_4002},
+            {0x4003, Enum, false, MessageScale::None, MessageUnit::None, MessageHandler::None, NAME_4003},
+            {0x4004, Enum, false, MessageScale::None, MessageUnit::None, MessageHandler::None, NAME_4004},
+            {0x4006, Enum, false, MessageScale::None, MessageUnit::None, MessageHandler::Log, NAME_4006},
+            {0x4007, Enum, false, MessageScale::None, MessageUnit::None, MessageHandler::Log, NAME_4007},
+            {0x4008, Enum, false, MessageScale::None, MessageUnit::None, MessageHandler::None, NAME_4008},
+            {0x4011, Enum, false, MessageScale::None, MessageUnit::None, MessageHandler::Log, NAME_4011},
+            {0x4012, Enum, false, MessageScale::None, MessageUnit::None, MessageHandler::None, NAME_4012},
+            {0x4038, Enum, false, MessageScale::None, MessageUnit::Percent, MessageHandler::Log, NAME_4038},
+            {0x4060, Enum, false, MessageScale::None, MessageUnit::None, MessageHandler::Log, NAME_4060},
+            {0x4065, Enum, false, MessageScale::None, MessageUnit::None, MessageHandler::Log, NAME_4065},
+            {0x407e, Enum, false, MessageScale::None, MessageUnit::None, MessageHandler::Log, NAME_407E},
+            {0x4201, Variable, true, MessageScale::Tenth, MessageUnit::Celsius, MessageHandler::None, NAME_4201},
+            {0x4203, Variable, true, MessageScale::Tenth, MessageUnit::Celsius, MessageHandler::None, NAME_4203},
+            {0x4205, Variable, true, MessageScale::Tenth, MessageUnit::Celsius, MessageHandler::None, NAME_4205},
+            {0x4206, Variable, true, MessageScale::Tenth, MessageUnit::Celsius, MessageHandler::None, NAME_4206},
+            {0x4211, Variable, false, MessageScale::Capacity, MessageUnit::KiloWatt, MessageHandler::None, NAME_4211},
+            {0x4237, Variable, true, MessageScale::Tenth, MessageUnit::Celsius, MessageHandler::Log, NAME_4237},
+            {0x4260, Variable, true, MessageScale::Tenth, MessageUnit::Celsius, MessageHandler::Log, NAME_4260},
+            {0x4261, Variable, true, MessageScale::Tenth, MessageUnit::Celsius, MessageHandler::Log, NAME_4261},
+            {0x4262, Variable, true, MessageScale::Tenth, MessageUnit::Celsius, MessageHandler::Log, NAME_4262},
+            {0x8001, Enum, false, MessageScale::None, MessageUnit::None, MessageHandler::None, NAME_8001},
+            {0x8003, Enum, false, MessageScale::None, MessageUnit::None, MessageHandler::None, NAME_8003},
+            {0x801a, Enum, false, MessageScale::None, MessageUnit::None, MessageHandler::None, NAME_801A},
+            {0x8204, Variable, true, MessageScale::Tenth, MessageUnit::Celsius, MessageHandler::Log, NAME_8204},
+            {0x8235, Variable, false, MessageScale::None, MessageUnit::None, MessageHandler::None, NAME_8235},
+            {0x8261, Variable, true, MessageScale::Tenth, MessageUnit::Celsius, MessageHandler::None, NAME_8261},
+            {0x8262, Variable, true, MessageScale::Tenth, MessageUnit::Celsius, MessageHandler::None, NAME_8262},
+            {0x8263, Variable, true, MessageScale::Tenth, MessageUnit::Celsius, MessageHandler::None, NAME_8263},
+            {0x8264, Variable, true, MessageScale::Tenth, MessageUnit::Celsius, MessageHandler::None, NAME_8264},
+            {0x8265, Variable, true, MessageScale::Tenth, MessageUnit::Celsius, MessageHandler::None, NAME_8265},
+            {0x8266, Variable, true, MessageScale::Tenth, MessageUnit::Celsius, MessageHandler::None, NAME_8266},
+            {0x8267, Variable, true, MessageScale::Tenth, MessageUnit::Celsius, MessageHandler::None, NAME_8267},
+            {0x8268, Variable, true, MessageScale::Tenth, MessageUnit::Celsius, MessageHandler::None, NAME_8268},
+            {0x8274, Variable, false, MessageScale::None, MessageUnit::Hertz, MessageHandler::None, NAME_8274},
+            {0x8275, Variable, false, MessageScale::None, MessageUnit::Hertz, MessageHandler::None, NAME_8275},
+            {0x8280, Variable, true, MessageScale::Tenth, MessageUnit::Celsius, MessageHandler::None, NAME_8280},
+            {0x82bc, Variable, false, MessageScale::None, MessageUnit::None, MessageHandler::None, NAME_82BC},
+            {0x82db, Variable, false, MessageScale::None, MessageUnit::None, MessageHandler::None, NAME_82DB},
+            {0x82e3, Variable, false, MessageScale::None, MessageUnit::None, MessageHandler::None, NAME_82E3},
+            {0x8411, LongVariable, false, MessageScale::None, MessageUnit::Watt, MessageHandler::Log, NAME_8411},
+            {0x8413, LongVariable, false, MessageScale::None, MessageUnit::Watt, MessageHandler::Log, NAME_8413},
+            {0x8414, LongVariable, false, MessageScale::Thousandth, MessageUnit::KiloWattHour, MessageHandler::Log, NAME_8414},
+            {0x8415, LongVariable, false, MessageScale::None, MessageUnit::Watt, MessageHandler::Log, NAME_8415},
+            {0x8416, LongVariable, false, MessageScale::None, MessageUnit::None, MessageHandler::Log, NAME_8416},
+            {0x8426, LongVariable, false, MessageScale::None, MessageUnit::None, MessageHandler::Log, NAME_8426},
+            {0x8427, LongVariable, false, MessageScale::None, MessageUnit::None, MessageHandler::Log, NAME_8427},
+        };
+
+        static constexpr size_t MESSAGE_REGISTRY_SIZE = sizeof(message_registry) / sizeof(message_registry[0]);
+
+        static constexpr bool message_registry_is_valid()
+        {
+            for (size_t i = 0; i < MESSAGE_REGISTRY_SIZE; i++)
+            {
+                if (i > 0 && message_registry[i - 1].number >= message_registry[i].number)
+                    return false;
+                if (message_registry[i].type != (MessageSetType)((message_registry[i].number & 0x600) >> 9))
+                    return false;
+            }
+            return true;
+        }
+
+        static_assert(message_registry_is_valid(), "message_registry must be sorted by number and the types must match the numbers");
+
+        bool find_message_info(uint16_t number, MessageInfo &info)
+        {
+            size_t low = 0;
+            size_t high = MESSAGE_REGISTRY_SIZE;
+            while (low < high)
+            {
+                const size_t mid = (low + high) / 2;
+                const MessageInfo *entry = &message_registry[mid];
+                const uint16_t entry_number = progmem_read_uint16(&entry->number);
+                if (entry_number < number)
+                {
+                    low = mid + 1;
+                }
+                else if (entry_number > number)
+                {
+                    high = mid;
+                }
+                else
+                {
+                    info.number = entry_number;
+                    info.type = (MessageSetType)progmem_read_byte((const uint8_t *)&entry->type);
+                    info.is_signed = progmem_read_byte((const uint8_t *)&entry->is_signed) != 0;
+                    info.scale = (MessageScale)progmem_read_byte((const uint8_t *)&entry->scale);
+                    info.unit = (MessageUnit)progmem_read_byte((const uint8_t *)&entry->unit);
+                    info.handler = (MessageHandler)progmem_read_byte((const uint8_t *)&entry->handler);
+                    info.name = progmem_read_ptr(&entry->name);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        void get_message_name(const MessageInfo &info, char *buffer, size_t size)
+        {
+            if (size == 0)
+                return;
+
+            size_t i = 0;
+            for (; i < size - 1; i++)
+            {
+                const char c = (char)progmem_read_byte((const uint8_t *)&info.name[i]);
+                if (c == 0)
+                    break;
+                buffer[i] = c;
+            }
+            buffer[i] = 0;
+        }
+
+        double get_message_value(const MessageInfo &info, long value)
+        {
+            double result;
+            if (info.type == Variable)
+            {
+                // MessageSet::decode always returns variables as signed
+                result = info.is_signed || value >= 0 ? (double)value : (double)(value + 65535);
+            }
+            else if (info.type == LongVariable)
+            {
+                result = info.is_signed ? (double)(int32_t)value : (double)(uint32_t)value;
+            }
+            else
+            {
+                result = (double)value;
+            }
+
+            switch (info.scale)
+            {
+            case MessageScale::Tenth:
+                return result / 10.0;
+            case MessageScale::Thousandth:
+                return result / 1000.0;
+            case MessageScale::Capacity:
+                return result / 8.6;
+            default:
+                return result;
+            }
+        }
+
+        const char *message_unit_to_string(MessageUnit unit)
+        {
+            switch (unit)
+            {
+            case MessageUnit::Celsius:
+                return "°C";
+            case MessageUnit::Percent:
+                return "%";
+            case MessageUnit::Hertz:
+                return "Hz";
+            case MessageUnit::Watt:
+                return "W";
+            case MessageUnit::KiloWatt:
+                return "kW";
+            case MessageUnit::KiloWattHour:
+                return "kWh";
+            default:
+                return "";
+            }
+        }
+
+        size_t message_registry_size()
+        {
+            return MESSAGE_REGISTRY_SIZE;
+        }
+    } // namespace samsung_ac
+} // namespace esphome
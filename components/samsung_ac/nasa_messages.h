@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include "protocol_nasa.h"
+
+namespace esphome
+{
+    namespace samsung_ac
+    {
+        // What process_messageset does with a message besides dispatching it to the subscribed entities.
+        enum class MessageHandler : uint8_t
+        {
+            None = 0,      // known, but nothing to do
+            Log = 1,       // log the decoded value
+            OperationMode, // log and forward the mode to the target
+        };
+
+        // Raw values are divided by these factors to get the value in the unit of the message.
+        enum class MessageScale : uint8_t
+        {
+            None = 0,   // 1
+            Tenth,      // 10
+            Thousandth, // 1000
+            Capacity,   // 8.6 (kcal/h to kW)
+        };
+
+        enum class MessageUnit : uint8_t
+        {
+            None = 0,
+            Celsius,
+            Percent,
+            Hertz,
+            Watt,
+            KiloWatt,
+            KiloWattHour,
+        };
+
+        struct MessageInfo
+        {
+            uint16_t number;
+            MessageSetType type;
+            bool is_signed;
+            MessageScale scale;
+            MessageUnit unit;
+            MessageHandler handler;
+            const char *name; // points to flash, use get_message_name() to read it
+        };
+
+        // Looks the message up in the registry (binary search over a table kept in flash).
+        // Returns false for message numbers the registry does not know.
+        bool find_message_info(uint16_t number, MessageInfo &info);
+
+        // Copies the name from flash into buffer (always null terminated).
+        void get_message_name(const MessageInfo &info, char *buffer, size_t size);
+
+        // Applies signedness and scale of the message to a decoded MessageSet value.
+        double get_message_value(const MessageInfo &info, long value);
+
+        const char *message_unit_to_string(MessageUnit unit);
+
+        // Number of entries in the registry, for tests.
+        size_t message_registry_size();
+    } // namespace samsung_ac
+} // namespace esphome
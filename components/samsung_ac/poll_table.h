@@ -0,0 +1,125 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <algorithm>
+#include "protocol.h"
+
+namespace esphome
+{
+    namespace samsung_ac
+    {
+        // Messages which are read actively from a device because it does not send them
+        // on its own (often enough). Every message has its own interval. The entries are
+        // sorted by destination, so all due messages of a device can be collected in one
+        // pass and asked for with a single packet. The first polls of the devices are
+        // spread over their intervals, so a start does not fill the send queue at once.
+        class PollTable
+        {
+        public:
+            struct Entry
+            {
+                uint64_t key; // destination << 16 | message number
+                uint32_t interval;
+                uint32_t next_due;
+
+                PackedAddress destination() const { return key >> 16; }
+                uint16_t message_number() const { return key & 0xFFFF; }
+            };
+
+            void add(PackedAddress destination, uint16_t message_number, uint32_t interval_ms)
+            {
+                Entry entry;
+                entry.key = make_key(destination, message_number);
+                entry.interval = interval_ms;
+                entry.next_due = 0;
+
+                auto it = lower_bound(entry.key);
+                if (it != entries_.end() && it->key == entry.key)
+                    it->interval = std::min(it->interval, interval_ms);
+                else
+                    entries_.insert(it, entry);
+                next_due_ = 0;
+                scheduled_ = false;
+            }
+
+            bool empty() const { return entries_.empty(); }
+
+            bool scheduled() const { return scheduled_; }
+
+            // Sets the first next_due of every entry: the n-th of m devices is polled
+            // n/m of an interval after now, all messages of one device together.
+            void schedule(uint32_t now)
+            {
+                size_t devices = 0;
+                for (size_t i = 0; i < entries_.size(); i++)
+                {
+                    if (i == 0 || entries_[i].destination() != entries_[i - 1].destination())
+                        devices++;
+                }
+
+                size_t device = 0;
+                for (size_t i = 0; i < entries_.size(); i++)
+                {
+                    if (i > 0 && entries_[i].destination() != entries_[i - 1].destination())
+                        device++;
+                    entries_[i].next_due = now + (uint64_t)entries_[i].interval * device / devices;
+                }
+
+                scheduled_ = true;
+                update_next_due();
+            }
+
+            // true when at least one message is due, cheap enough for every loop
+            bool any_due(uint32_t now) const
+            {
+                return !entries_.empty() && (int32_t)(now - next_due_) >= 0;
+            }
+
+            std::vector<Entry> &entries() { return entries_; }
+
+            // Called after a pass over the entries updated their next_due.
+            void update_next_due()
+            {
+                if (entries_.empty())
+                    return;
+
+                next_due_ = entries_.front().next_due;
+                for (const auto &entry : entries_)
+                {
+                    if ((int32_t)(entry.next_due - next_due_) < 0)
+                        next_due_ = entry.next_due;
+                }
+            }
+
+            // A value which arrived anyway (e.g. by notification) does not need to be polled.
+            void seen(PackedAddress source, uint16_t message_number, uint32_t now)
+            {
+                if (entries_.empty())
+                    return;
+
+                const uint64_t key = make_key(source, message_number);
+                auto it = lower_bound(key);
+                if (it != entries_.end() && it->key == key)
+                    it->next_due = now + it->interval;
+            }
+
+        protected:
+            static uint64_t make_key(PackedAddress address, uint16_t message_number)
+            {
+                return (uint64_t)address << 16 | message_number;
+            }
+
+            std::vector<Entry>::iterator lower_bound(uint64_t key)
+            {
+                return std::lower_bound(entries_.begin(), entries_.end(), key, [](const Entry &entry, uint64_t key)
+                                        { return entry.key < key; });
+            }
+
+            std::vector<Entry> entries_;
+            uint32_t next_due_{0};
+            bool scheduled_{false};
+        };
+    } // namespace samsung_ac
+} // namespace esphome
@@ -1,59 +1,225 @@
+#include <cstring>
 #include "esphome/core/log.h"
 #include "protocol.h"
 #include "util.h"
 #include "protocol_nasa.h"
 #include "protocol_non_nasa.h"
+#include "decoder_context.h"
 
 namespace esphome
 {
     namespace samsung_ac
     {
-        bool debug_log_packets = false;
-        bool debug_log_raw_bytes = false;
 
-        // This functions is designed to run after a new value was added
-        // to the data vector. One by one.
-        DataResult process_data(std::vector<uint8_t> &data, MessageTarget *target)
+        bool Framer::push(uint8_t value)
         {
-            if (data.size() > 1500)
+            if (begin_ + size_ + backlog_ == MAX_PACKET_SIZE)
             {
-                ESP_LOGV(TAG, "current packat exceeds the size limits: %s", bytes_to_hex(data).c_str());
+                if (begin_ == 0)
+                {
+                    // only possible when a complete frame was not released with next()
+                    ESP_LOGV(TAG, "framer overflow: %s", bytes_to_hex(data_, MAX_PACKET_SIZE).c_str());
+                    clear();
+                }
+                else
+                {
+                    memmove(data_, data_ + begin_, size_ + backlog_);
+                    begin_ = 0;
+                }
+            }
+
+            data_[begin_ + size_ + backlog_++] = value;
+
+            if (complete_)
+                return false; // queued until the current frame is released with next()
+
+            return process();
+        }
+
+        bool Framer::next()
+        {
+            complete_ = false;
+            begin_ += size_;
+            size_ = 0;
+            expected_size_ = 0;
+            crc_ = 0;
+            return process();
+        }
+
+        void Framer::clear()
+        {
+            begin_ = 0;
+            size_ = 0;
+            backlog_ = 0;
+            expected_size_ = 0;
+            crc_ = 0;
+            complete_ = false;
+        }
+
+        bool Framer::process()
+        {
+            while (backlog_ > 0)
+            {
+                const uint8_t value = data_[begin_ + size_];
+                backlog_--;
+
+                if (size_ == 0 && value != 0x32)
+                {
+                    begin_++; // skip until start-byte found, this also drops the 0x55 preamble
+                    continue;
+                }
+
+                size_++;
+                switch (check(value))
+                {
+                case FrameState::Incomplete:
+                    break;
+                case FrameState::Complete:
+                    complete_ = true;
+                    return true;
+                case FrameState::Invalid:
+                    resync();
+                    break;
+                }
+            }
+
+            if (size_ == 0)
+                begin_ = 0;
+
+            return false;
+        }
+
+        Framer::FrameState Framer::check(uint8_t value)
+        {
+            const uint8_t *frame = data_ + begin_;
+
+            if (size_ == 3)
+            {
+                expected_size_ = ((uint16_t)frame[1] << 8 | (uint16_t)frame[2]) + 2;
+                if (expected_size_ < 16 || expected_size_ > MAX_PACKET_SIZE)
+                    expected_size_ = 0; // can only be a NonNASA packet
+            }
+            else if (expected_size_ != 0 && size_ <= expected_size_ - 3)
+            {
+                // checksum covers everything between the length and the checksum itself
+                crc_ = crc16_update(crc_, value);
+            }
+
+            // NonNASA packets have no length information, so check them at their known sizes
+            if ((size_ == 7 /* duplicate addr package */ || size_ == 14 /* generic package */) && is_non_nasa_packet(frame, size_))
+            {
+                expected_size_ = 0;
+                return FrameState::Complete;
+            }
+
+            if (expected_size_ == 0)
+            {
+                if (size_ < 14)
+                    return FrameState::Incomplete;
+
+                ESP_LOGV(TAG, "invalid packet length: %s", bytes_to_hex(frame, size_).c_str());
+                return FrameState::Invalid;
+            }
+
+            if (size_ < expected_size_)
+                return FrameState::Incomplete;
+
+            if (frame[size_ - 1] != 0x34)
+            {
+                ESP_LOGV(TAG, "invalid end byte: %s", bytes_to_hex(frame, size_).c_str());
+                return FrameState::Invalid;
+            }
+
+            const uint16_t crc_expected = (uint16_t)frame[size_ - 3] << 8 | (uint16_t)frame[size_ - 2];
+            if (crc_ != crc_expected)
+            {
+                ESP_LOGW(TAG, "NASA: invalid crc - got %d but should be %d: %s", crc_, crc_expected, bytes_to_hex(frame, size_).c_str());
+                return FrameState::Invalid;
+            }
+
+            return FrameState::Complete;
+        }
+
+        // Drops the start byte of a broken frame and moves everything behind the next
+        // plausible start back to the backlog, so a frame which began inside the broken
+        // one (e.g. after a lost byte) is not lost as well.
+        void Framer::resync()
+        {
+            const uint8_t *frame = data_ + begin_;
+            const uint16_t available = size_ + backlog_;
+
+            uint16_t start = 1;
+            while (start < size_ && !is_plausible_start(frame + start, available - start))
+                start++;
+
+            ESP_LOGV(TAG, "resync: dropped %d bytes", start);
+
+            begin_ += start;
+            backlog_ += size_ - start;
+            size_ = 0;
+            expected_size_ = 0;
+            crc_ = 0;
+        }
+
+        bool Framer::is_plausible_start(const uint8_t *data, uint16_t available)
+        {
+            if (data[0] != 0x32)
+                return false;
+            if (available < 3)
+                return true; // can't tell yet
+
+            const uint16_t size = ((uint16_t)data[1] << 8 | (uint16_t)data[2]) + 2;
+            if (size >= 16 && size <= MAX_PACKET_SIZE)
+                return true; // NASA length header
+
+            // NonNASA packets have a fixed size of 7 or 14 bytes
+            if (available >= 7 && data[6] == 0x34)
+                return true;
+            return available < 14 || data[13] == 0x34;
+        }
+
+        // This functions is designed to run once the framer has collected a complete packet.
+        DataResult process_data(DecoderContext &context, const uint8_t *data, size_t size, MessageTarget *target, bool crc_checked)
+        {
+            if (size > MAX_PACKET_SIZE)
+            {
+                ESP_LOGV(TAG, "current packat exceeds the size limits: %s", bytes_to_hex(data, size).c_str());
                 return DataResult::Clear;
             }
 
             // Check if its a decodeable NonNASA packat
-            if (data.size() == 7 /* duplicate addr package */ || data.size() == 14 /* generic package */)
+            if (size == 7 /* duplicate addr package */ || size == 14 /* generic package */)
             {
-                const auto result = try_decode_non_nasa_packet(data);
+                const auto result = try_decode_non_nasa_packet(context, data, size);
                 if (result == DecodeResult::Ok)
                 {
-                    if (debug_log_raw_bytes)
+                    if (context.debug_log_raw_bytes)
                     {
-                        ESP_LOGW(TAG, "RAW: %s", bytes_to_hex(data).c_str());
+                        ESP_LOGW(TAG, "RAW: %s", bytes_to_hex(data, size).c_str());
                     }
 
-                    process_non_nasa_packet(target);
+                    process_non_nasa_packet(context, target);
                     return DataResult::Clear;
                 }
             }
 
-            const auto result = try_decode_nasa_packet(data);
+            const auto result = try_decode_nasa_packet(context, data, size, crc_checked);
             if (result == DecodeResult::SizeDidNotMatch || result == DecodeResult::UnexpectedSize)
                 return DataResult::Fill;
 
-            if (debug_log_raw_bytes)
+            if (context.debug_log_raw_bytes)
             {
-                ESP_LOGV(TAG, "RAW: %s", bytes_to_hex(data).c_str());
+                ESP_LOGV(TAG, "RAW: %s", bytes_to_hex(data, size).c_str());
             }
 
             if (result == DecodeResult::InvalidStartByte)
             {
-                ESP_LOGV(TAG, "invalid start byte: %s", bytes_to_hex(data).c_str());
+                ESP_LOGV(TAG, "invalid start byte: %s", bytes_to_hex(data, size).c_str());
                 return DataResult::Clear;
             }
             else if (result == DecodeResult::InvalidEndByte)
             {
-                ESP_LOGV(TAG, "invalid end byte: %s", bytes_to_hex(data).c_str());
+                ESP_LOGV(TAG, "invalid end byte: %s", bytes_to_hex(data, size).c_str());
                 return DataResult::Clear;
             }
             else if (result == DecodeResult::CrcError)
@@ -61,22 +227,77 @@ namespace esphome
                 // is logge dwithin decoder
                 return DataResult::Clear;
             }
+            else if (result == DecodeResult::InvalidMessageSet)
+            {
+                ESP_LOGV(TAG, "invalid message set: %s", bytes_to_hex(data, size).c_str());
+                return DataResult::Clear;
+            }
+
+            if (is_filtered_nasa_packet(context) || is_duplicate_nasa_packet(context, data, size, target->get_miliseconds()))
+                return DataResult::Clear;
 
-            process_nasa_packet(target);
+            process_nasa_packet(context, target);
             return DataResult::Clear;
         }
 
-        bool is_nasa_address(const std::string &address)
+        // NASA addresses are written as "10.00.00", NonNASA addresses as "c8"
+        PackedAddress parse_address(const std::string &address)
         {
-            return address.size() != 2;
+            if (address.size() == 2)
+                return NON_NASA_ADDRESS_FLAG | hex_to_int(address);
+
+            return Address::parse(address).to_packed();
         }
 
-        AddressType get_address_type(const std::string &address)
+        std::string address_to_string(PackedAddress address)
         {
-            if (address == "c8" || address.rfind("10.", 0) == 0)
-                return AddressType::Outdoor;
+            char str[9];
+            if (is_nasa_address(address))
+                sprintf(str, "%02x.%02x.%02x", (int)(address >> 16) & 0xFF, (int)(address >> 8) & 0xFF, (int)address & 0xFF);
+            else
+                sprintf(str, "%02x", (int)address & 0xFF);
+            return str;
+        }
+
+        bool is_nasa_address(PackedAddress address)
+        {
+            return (address & NON_NASA_ADDRESS_FLAG) == 0;
+        }
+
+        const char *tx_priority_to_string(TxPriority priority)
+        {
+            switch (priority)
+            {
+            case TxPriority::Control:
+                return "control";
+            case TxPriority::Retry:
+                return "retry";
+            case TxPriority::Poll:
+                return "poll";
+            default:
+                return "unknown";
+            }
+        }
 
-            if (address == "00" || address == "01" || address == "02" || address == "03" || address.rfind("20.", 0) == 0)
+        AddressType get_address_type(PackedAddress address)
+        {
+            if (is_nasa_address(address))
+            {
+                switch ((AddressClass)(address >> 16))
+                {
+                case AddressClass::Outdoor:
+                    return AddressType::Outdoor;
+                case AddressClass::Indoor:
+                    return AddressType::Indoor;
+                default:
+                    return AddressType::Other;
+                }
+            }
+
+            const uint8_t value = address & 0xFF;
+            if (value == 0xc8)
+                return AddressType::Outdoor;
+            if (value <= 0x03)
                 return AddressType::Indoor;
 
             return AddressType::Other;
@@ -85,7 +306,7 @@ namespace esphome
         Protocol *nasaProtocol = new NasaProtocol();
         Protocol *nonNasaProtocol = new NonNasaProtocol();
 
-        Protocol *get_protocol(const std::string &address)
+        Protocol *get_protocol(PackedAddress address)
         {
             if (!is_nasa_address(address))
                 return nonNasaProtocol;
@@ -9,8 +9,15 @@ namespace esphome
     namespace samsung_ac
     {
         class Samsung_AC_CustClim;
-        extern bool debug_log_packets;
-        extern bool debug_log_raw_bytes;
+        struct DecoderContext;
+
+        static const uint16_t MAX_PACKET_SIZE = 1500;
+
+        // Device addresses are passed around as packed integers, strings are only
+        // created for the configuration and for logging.
+        // NASA: class << 16 | channel << 8 | address, NonNASA: NON_NASA_ADDRESS_FLAG | address
+        typedef uint32_t PackedAddress;
+        static const PackedAddress NON_NASA_ADDRESS_FLAG = 0x01000000;
 
         enum class DecodeResult
         {
@@ -19,7 +26,8 @@ namespace esphome
             InvalidEndByte = 2,
             SizeDidNotMatch = 3,
             UnexpectedSize = 4,
-            CrcError = 5
+            CrcError = 5,
+            InvalidMessageSet = 6
         };
 
         enum class Mode
@@ -60,21 +68,35 @@ namespace esphome
             All = 3
         };
 
+        // Transmit queue classes, highest priority first.
+        enum class TxPriority : uint8_t
+        {
+            Control = 0, // changes made by the user
+            Retry = 1,   // requests which were not acknowledged
+            Poll = 2,    // background reads
+        };
+
+        const char *tx_priority_to_string(TxPriority priority);
+
         class MessageTarget
         {
         public:
             virtual uint32_t get_miliseconds() = 0;
-            virtual void publish_data(std::vector<uint8_t> &data) = 0;
-            virtual void register_address(const std::string address) = 0;
-
-            virtual void set_mode(const std::string address, Mode mode) = 0;
-            virtual optional<std::set<uint16_t>> get_custom_sensors(const std::string address) = 0;
-            virtual void set_custom_sensor(const std::string address, uint16_t message_number, float value) = 0;
-            virtual optional<std::set<uint16_t>> get_custom_switches(const std::string address) = 0;
-            virtual void set_custom_switch(const std::string address, uint16_t message_number, bool value) = 0;
-            virtual optional<std::set<uint16_t>> get_custom_numbers(const std::string address) = 0;
-            virtual void set_custom_number(const std::string address, uint16_t message_number, float value) = 0;
-            virtual void getValueForCustomClimate(const std::string source, uint16_t messageNumber, long value) = 0;
+            // millis() when the frame which is processed right now was received
+            virtual uint32_t get_frame_received_miliseconds() = 0;
+            virtual DecoderContext &get_decoder_context() = 0;
+            // writes the data right away, false when it collided and should be sent again
+            virtual bool publish_data(std::vector<uint8_t> &data) = 0;
+            // sends the data as soon as the bus is idle and no frame of a higher priority waits,
+            // false when the queue is full
+            virtual bool queue_data(std::vector<uint8_t> &data, TxPriority priority) = 0;
+            virtual void register_address(PackedAddress address) = 0;
+
+            virtual void set_mode(PackedAddress address, Mode mode) = 0;
+            // Passes a received message value to every entity which is bound to it
+            virtual void dispatch_message(PackedAddress address, uint16_t message_number, long value) = 0;
+            // true when any entity is bound to the message, others don't need to be decoded
+            virtual bool is_subscribed(PackedAddress address, uint16_t message_number) = 0;
         };
 
         struct ProtocolRequest
@@ -96,7 +118,7 @@ namespace esphome
         class Protocol
         {
         public:
-            virtual void publish_request(MessageTarget *target, const std::string &address, ProtocolRequest &request) = 0;
+            virtual void publish_request(MessageTarget *target, PackedAddress address, ProtocolRequest &request) = 0;
         };
 
         enum class DataResult
@@ -105,11 +127,61 @@ namespace esphome
             Clear = 1
         };
 
-        DataResult process_data(std::vector<uint8_t> &data, MessageTarget *target);
+        // Assembles frames from the received byte stream. NASA frames announce their
+        // length in the two bytes after the start byte, so we only collect bytes until
+        // the frame is complete and the decoder has to run exactly once per frame.
+        // Frames are kept contiguous in a fixed buffer, so decoders can read them in
+        // place. The NASA checksum is updated with every received byte, so validating
+        // it once the frame is complete is cheap.
+        // When a frame turns out to be broken (wrong end byte, checksum or length) the
+        // framer continues at the next plausible start byte inside the collected bytes
+        // instead of dropping them, so one corrupted byte does not cost the next frame.
+        class Framer
+        {
+        public:
+            // Adds one received byte. Returns true when data() holds a complete frame.
+            bool push(uint8_t value);
+            // Releases the complete frame. Returns true when the bytes collected behind
+            // it already hold the next complete frame.
+            bool next();
+            void clear();
+
+            const uint8_t *data() const { return data_ + begin_; }
+            uint16_t size() const { return size_; }
+            bool empty() const { return size_ == 0 && backlog_ == 0; }
+            // true when data() holds a NASA packet with an already validated checksum
+            bool crc_checked() const { return expected_size_ != 0; }
+
+        protected:
+            enum class FrameState
+            {
+                Incomplete,
+                Complete,
+                Invalid
+            };
+
+            bool process();
+            FrameState check(uint8_t value);
+            void resync();
+            static bool is_plausible_start(const uint8_t *data, uint16_t available);
+
+            uint8_t data_[MAX_PACKET_SIZE];
+            uint16_t begin_{0};         // start of the current frame within data_
+            uint16_t size_{0};          // bytes of the current frame
+            uint16_t backlog_{0};       // bytes behind the current frame which still need to be checked
+            uint16_t expected_size_{0}; // 0 = length unknown or not a NASA frame
+            uint16_t crc_{0};
+            bool complete_{false};
+        };
+
+        DataResult process_data(DecoderContext &context, const uint8_t *data, size_t size, MessageTarget *target, bool crc_checked = false);
+
+        PackedAddress parse_address(const std::string &address);
+        std::string address_to_string(PackedAddress address);
 
-        Protocol *get_protocol(const std::string &address);
+        Protocol *get_protocol(PackedAddress address);
 
-        bool is_nasa_address(const std::string &address);
+        bool is_nasa_address(PackedAddress address);
 
         enum class AddressType
         {
@@ -118,7 +190,7 @@ namespace esphome
             Other = 2
         };
 
-        AddressType get_address_type(const std::string &address);
+        AddressType get_address_type(PackedAddress address);
 
     } // namespace samsung_ac
 } // namespace esphome
@@ -1,4 +1,5 @@
 #include <queue>
+#include <algorithm>
 #include <iostream>
 #include <set>
 #include "esphome/core/log.h"
@@ -9,8 +10,8 @@
 #include "debug_mqtt.h"
 #include "samsung_ac_device_custClim.h"
 #include "debug_number.h"
-
-esphome::samsung_ac::Packet packet_;
+#include "decoder_context.h"
+#include "nasa_messages.h"
 
 namespace esphome
 {
@@ -23,23 +24,6 @@ namespace esphome
             return value - (int)65535 /*uint16 max*/ - 1.0;
         }
 
-        uint16_t crc16(std::vector<uint8_t> &data, int startIndex, int length)
-        {
-            uint16_t crc = 0;
-            for (int index = startIndex; index < startIndex + length; ++index)
-            {
-                crc = crc ^ ((uint16_t)((uint8_t)data[index]) << 8);
-                for (uint8_t i = 0; i < 8; i++)
-                {
-                    if (crc & 0x8000)
-                        crc = (crc << 1) ^ 0x1021;
-                    else
-                        crc <<= 1;
-                }
-            }
-            return crc;
-        };
-
         Address Address::get_my_address()
         {
             Address address;
@@ -61,7 +45,16 @@ namespace esphome
             return address;
         }
 
-        void Address::decode(std::vector<uint8_t> &data, unsigned int index)
+        Address Address::from_packed(PackedAddress packed)
+        {
+            Address address;
+            address.klass = (AddressClass)((packed >> 16) & 0xFF);
+            address.channel = (packed >> 8) & 0xFF;
+            address.address = packed & 0xFF;
+            return address;
+        }
+
+        void Address::decode(const uint8_t *data, unsigned int index)
         {
             klass = (AddressClass)data[index];
             channel = data[index + 1];
@@ -82,7 +75,7 @@ namespace esphome
             return str;
         }
 
-        void Command::decode(std::vector<uint8_t> &data, unsigned int index)
+        void Command::decode(const uint8_t *data, unsigned int index)
         {
             packetInformation = ((int)data[index] & 128) >> 7 == 1;
             protocolVersion = (uint8_t)(((int)data[index] & 96) >> 5);
@@ -113,46 +106,113 @@ namespace esphome
             return str;
         }
 
-        MessageSet MessageSet::decode(std::vector<uint8_t> &data, unsigned int index, int capacity)
+        long MessageSetView::value() const
         {
-            MessageSet set = MessageSet((MessageNumber)((uint32_t)data[index] * 256U + (uint32_t)data[index + 1]));
-            switch (set.type)
+            long value = 0;
+            switch (type)
             {
             case Enum:
-                set.value = (int)data[index + 2];
-                set.size = 3;
+                value = (int)payload[0];
                 break;
             case Variable:
-                set.value = (int)data[index + 2] << 8 | (int)data[index + 3];
-                if (set.value > 32768) set.value -= 65535;
-                set.size = 4;
+                value = (int)payload[0] << 8 | (int)payload[1];
+                if (value > 32768) value -= 65535;
                 break;
             case LongVariable:
-                set.value = (int)data[index + 2] << 24 | (int)data[index + 3] << 16 | (int)data[index + 4] << 8 | (int)data[index + 5];
-                set.size = 6;
+                value = (int)payload[0] << 24 | (int)payload[1] << 16 | (int)payload[2] << 8 | (int)payload[3];
                 break;
+            default:
+                break;
+            }
+            return value;
+        }
 
-            case Structure:
-                if (capacity != 1)
-                {
-                    ESP_LOGE(TAG, "structure messages can only have one message but is %d", capacity);
-                    return set;
-                }
-                Buffer buffer;
-                set.size = data.size() - index - 3; // 3=end bytes
-                buffer.size = set.size - 2;
-                for (int i = 0; i < buffer.size; i++)
+        MessageSet MessageSetView::to_message_set() const
+        {
+            MessageSet set((MessageNumber)number);
+            if (type == Structure)
+            {
+                set.structure = payload;
+                set.structure_size = payload_size;
+            }
+            else
+            {
+                set.value = value();
+            }
+            return set;
+        }
+
+        MessageSetIterator::MessageSetIterator(const uint8_t *data, size_t size)
+        {
+            data_ = data;
+            end_ = size - 3; // messages end in front of the crc and the end byte
+            cursor_ = 13;    // start byte, size, sa, da, command and capacity
+            capacity_ = data[12];
+            remaining_ = capacity_;
+        }
+
+        bool MessageSetIterator::next(MessageSetView &view)
+        {
+            if (remaining_ == 0 || failed_)
+                return false;
+
+            if (cursor_ + 2 > end_)
+            {
+                failed_ = true;
+                return false;
+            }
+
+            view.number = (uint16_t)data_[cursor_] << 8 | data_[cursor_ + 1];
+            view.type = (MessageSetType)((view.number & 0x600) >> 9);
+            view.payload = &data_[cursor_ + 2];
+
+            switch (view.type)
+            {
+            case Enum:
+                view.payload_size = 1;
+                break;
+            case Variable:
+                view.payload_size = 2;
+                break;
+            case LongVariable:
+                view.payload_size = 4;
+                break;
+            default:
+                if (capacity_ != 1)
                 {
-                    buffer.data[i] = data[i];
+                    ESP_LOGE(TAG, "structure messages can only have one message but is %d", capacity_);
+                    failed_ = true;
+                    return false;
                 }
-                set.structure = buffer;
+                view.payload_size = end_ - cursor_ - 2;
                 break;
-            default:
-                ESP_LOGE(TAG, "Unkown type");
             }
 
-            return set;
-        };
+            if (cursor_ + 2 + view.payload_size > end_)
+            {
+                failed_ = true;
+                return false;
+            }
+
+            cursor_ += 2 + view.payload_size;
+            remaining_--;
+            return true;
+        }
+
+        uint16_t MessageSet::size() const
+        {
+            switch (type)
+            {
+            case Enum:
+                return 3;
+            case Variable:
+                return 4;
+            case LongVariable:
+                return 6;
+            default:
+                return 2 + structure_size;
+            }
+        }
 
         void MessageSet::encode(std::vector<uint8_t> &data)
         {
@@ -178,10 +238,7 @@ namespace esphome
                 break;
 
             case Structure:
-                for (int i = 0; i < structure.size; i++)
-                {
-                    data.push_back(structure.data[i]);
-                }
+                data.insert(data.end(), structure, structure + structure_size);
                 break;
             default:
                 ESP_LOGE(TAG, "Unkown type");
@@ -199,16 +256,12 @@ namespace esphome
             case LongVariable:
                 return "LongVariable " + long_to_hex((uint16_t)messageNumber) + " = " + std::to_string(value);
             case Structure:
-                return "Structure #" + long_to_hex((uint16_t)messageNumber) + " = " + std::to_string(structure.size);
+                return "Structure #" + long_to_hex((uint16_t)messageNumber) + " = " + std::to_string(structure_size);
             default:
                 return "Unknown";
             }
         }
 
-        static int _packetCounter = 0;
-
-        std::vector<Packet> out;
-
         /*
                 class OutgoingPacket
                 {
@@ -237,7 +290,6 @@ namespace esphome
             MessageSet message(messageNumber);
             message.value = value;
             packet.messages.push_back(message);
-            out.push_back(packet);
 
             return packet;
         }
@@ -250,30 +302,29 @@ namespace esphome
             packet.command.packetInformation = true;
             packet.command.packetType = PacketType::Normal;
             packet.command.dataType = dataType;
-            packet.command.packetNumber = _packetCounter++;
             return packet;
         }
 
-        DecodeResult Packet::decode(std::vector<uint8_t> &data)
+        DecodeResult Packet::decode_header(const uint8_t *data, size_t data_size, bool crc_checked)
         {
             if (data[0] != 0x32)
                 return DecodeResult::InvalidStartByte;
 
-            if (data.size() < 16 || data.size() > 1500)
+            if (data_size < 16 || data_size > MAX_PACKET_SIZE)
                 return DecodeResult::UnexpectedSize;
 
             int size = (int)data[1] << 8 | (int)data[2];
-            if (size + 2 != data.size())
+            if (size + 2 != data_size)
                 return DecodeResult::SizeDidNotMatch;
 
-            if (data[data.size() - 1] != 0x34)
+            if (data[data_size - 1] != 0x34)
                 return DecodeResult::InvalidEndByte;
 
-            uint16_t crc_actual = crc16(data, 3, size - 4);
-            uint16_t crc_expected = (int)data[data.size() - 3] << 8 | (int)data[data.size() - 2];
-            if (crc_expected != crc_actual)
+            uint16_t crc_actual = crc_checked ? 0 : crc16(data + 3, size - 4);
+            uint16_t crc_expected = (int)data[data_size - 3] << 8 | (int)data[data_size - 2];
+            if (!crc_checked && crc_expected != crc_actual)
             {
-                ESP_LOGW(TAG, "NASA: invalid crc - got %d but should be %d: %s", crc_actual, crc_expected, bytes_to_hex(data).c_str());
+                ESP_LOGW(TAG, "NASA: invalid crc - got %d but should be %d: %s", crc_actual, crc_expected, bytes_to_hex(data, data_size).c_str());
                 return DecodeResult::CrcError;
             }
 
@@ -288,19 +339,33 @@ namespace esphome
             command.decode(data, cursor);
             cursor += command.size;
 
-            int capacity = (int)data[cursor];
-            cursor++;
+            messages.clear();
+            return DecodeResult::Ok;
+        };
+
+        DecodeResult Packet::decode(const uint8_t *data, size_t data_size, bool crc_checked)
+        {
+            const DecodeResult result = decode_header(data, data_size, crc_checked);
+            if (result != DecodeResult::Ok)
+                return result;
+
+            return decode_messages(data, data_size);
+        }
 
+        DecodeResult Packet::decode_messages(const uint8_t *data, size_t data_size)
+        {
+            // the vector of the decoder context is reserved for MAX_MESSAGES_PER_PACKET
+            // so decoding does not allocate
             messages.clear();
-            for (int i = 1; i <= capacity; ++i)
+            MessageSetIterator iterator(data, data_size);
+            MessageSetView view;
+            while (iterator.next(view))
             {
-                MessageSet set = MessageSet::decode(data, cursor, capacity);
-                messages.push_back(set);
-                cursor += set.size;
+                messages.push_back(view.to_message_set());
             }
 
-            return DecodeResult::Ok;
-        };
+            return iterator.failed() ? DecodeResult::InvalidMessageSet : DecodeResult::Ok;
+        }
 
         std::vector<uint8_t> Packet::encode()
         {
@@ -323,7 +388,7 @@ namespace esphome
             data[1] = (uint8_t)(endPosition >> 8);
             data[2] = (uint8_t)(endPosition & (int)0xFF);
 
-            uint16_t checksum = crc16(data, 3, endPosition - 4);
+            uint16_t checksum = crc16(data.data() + 3, endPosition - 4);
             data.push_back((uint8_t)((unsigned int)checksum >> 8));
             data.push_back((uint8_t)((unsigned int)checksum & (unsigned int)0xFF));
 
@@ -371,17 +436,62 @@ namespace esphome
             }
         }
 
-        void NasaProtocol::publish_request(MessageTarget *target, const std::string &address, ProtocolRequest &request)
+        void send_nasa_request(DecoderContext &context, MessageTarget *target, PackedAddress address, std::vector<MessageSet> &messages, bool broadcast)
+        {
+            Packet packet = Packet::createa_partial(Address::from_packed(address), DataType::Request);
+            packet.command.packetNumber = context.packet_counter++;
+            packet.messages.swap(messages);
+
+            auto data = packet.encode();
+            if (broadcast)
+            {
+                // nobody acknowledges a broadcast, so it is not kept for retransmission
+                ESP_LOGW(TAG, "publish broadcast %s", packet.to_string().c_str());
+                if (!target->queue_data(data, TxPriority::Control))
+                    ESP_LOGE(TAG, "Broadcast #%d to %s could not be queued", packet.command.packetNumber, address_to_string(address).c_str());
+                return;
+            }
+
+            ESP_LOGW(TAG, "publish packet %s", packet.to_string().c_str());
+            if (!context.requests.add(packet.command.packetNumber, address, data, target->get_miliseconds()))
+                ESP_LOGW(TAG, "Too many unacknowledged requests, gave up on the oldest one");
+            if (!target->queue_data(data, TxPriority::Control))
+            {
+                // it would never be sent, so it must not wait for an Ack either
+                ESP_LOGE(TAG, "Request #%d to %s could not be queued", packet.command.packetNumber, address_to_string(address).c_str());
+                context.requests.drop(packet.command.packetNumber);
+            }
+        }
+
+        void send_pending_nasa_requests(DecoderContext &context, MessageTarget *target, uint32_t now)
         {
-            Packet packet = Packet::createa_partial(Address::parse(address), DataType::Request);
+            for (auto it = context.pending_requests.begin(); it != context.pending_requests.end();)
+            {
+                // the others wait until Acks (or timeouts) make room
+                if (context.requests.size() >= MAX_REQUESTS_IN_FLIGHT)
+                    return;
+
+                if ((int32_t)(now - it->second.deadline) < 0)
+                {
+                    ++it;
+                    continue;
+                }
+
+                send_nasa_request(context, target, it->first, it->second.messages, it->second.broadcast);
+                it = context.pending_requests.erase(it);
+            }
+        }
 
+        // Translates the changes of a request into message sets. The address is only used for logging.
+        static void request_to_messages(PackedAddress address, ProtocolRequest &request, std::vector<MessageSet> &messages)
+        {
             if (request.caller.has_value()) { // customClimate
                 Samsung_AC_CustClim *caller = request.caller.value();
                 if (caller->presToSend >= 0) {
                     MessageSet pres((MessageNumber)caller->presAddr);
                     pres.value = caller->presToSend;
-                    packet.messages.push_back(pres);
-                    ESP_LOGI(TAG, "Pushing pres %i at 0x%X for %s", pres.value, (MessageNumber)caller->presAddr, address.c_str());
+                    messages.push_back(pres);
+                    ESP_LOGI(TAG, "Pushing pres %i at 0x%X for %s", pres.value, (MessageNumber)caller->presAddr, address_to_string(address).c_str());
                     caller->presToSend = -1;
                 }
             }
@@ -396,8 +506,8 @@ namespace esphome
                 }
                 MessageSet mode(addr);
                 mode.value = (int)request.mode.value();
-                packet.messages.push_back(mode);
-                ESP_LOGI(TAG, "Pushing mode %i at 0x%X for %s", mode.value , addr, address.c_str());
+                messages.push_back(mode);
+                ESP_LOGI(TAG, "Pushing mode %i at 0x%X for %s", mode.value , addr, address_to_string(address).c_str());
             }
 
             if (request.power)
@@ -405,8 +515,8 @@ namespace esphome
                 MessageNumber addr = request.caller.has_value() ? (MessageNumber)request.caller.value()->enable: MessageNumber::ENUM_in_operation_power;
                 MessageSet power(addr);
                 power.value = request.power.value() ? 1 : 0;
-                packet.messages.push_back(power);
-                ESP_LOGI(TAG, "Pushing power %u at 0x%X for %s", power.value  , addr, address.c_str());
+                messages.push_back(power);
+                ESP_LOGI(TAG, "Pushing power %u at 0x%X for %s", power.value  , addr, address_to_string(address).c_str());
             }
 
             if (request.target_temp)
@@ -414,59 +524,106 @@ namespace esphome
                 MessageNumber addr = request.caller.has_value() ? (MessageNumber)request.caller.value()->set: MessageNumber::VAR_in_temp_target_f;
                 MessageSet targettemp(addr);
                 targettemp.value = request.target_temp.value() * 10.0;
-                packet.messages.push_back(targettemp);
+                messages.push_back(targettemp);
             }
 
             if (request.fan_mode)
             {
                 MessageSet fanmode(MessageNumber::ENUM_in_fan_mode);
                 fanmode.value = fanmode_to_nasa_fanmode(request.fan_mode.value());
-                packet.messages.push_back(fanmode);
+                messages.push_back(fanmode);
             }
 
             if (request.alt_mode)
             {
                 MessageSet altmode(MessageNumber::ENUM_in_alt_mode);
                 altmode.value = request.alt_mode.value();
-                packet.messages.push_back(altmode);
+                messages.push_back(altmode);
             }
 
             if (request.swing_mode)
             {
                 MessageSet hl_swing(MessageNumber::ENUM_in_louver_hl_swing);
                 hl_swing.value = static_cast<uint8_t>(request.swing_mode.value()) & 1;
-                packet.messages.push_back(hl_swing);
+                messages.push_back(hl_swing);
 
                 MessageSet lr_swing(MessageNumber::ENUM_in_louver_lr_swing);
                 lr_swing.value = (static_cast<uint8_t>(request.swing_mode.value()) >> 1) & 1;
-                packet.messages.push_back(lr_swing);
+                messages.push_back(lr_swing);
             }
 
             if (request.custom_switch_message && request.custom_switch_value)
             {
                 MessageSet custom_switch((MessageNumber)request.custom_switch_message.value());
                 custom_switch.value = request.custom_switch_value.value() ? 1 : 0;
-                packet.messages.push_back(custom_switch);
-                ESP_LOGI(TAG, "Pushing custom switch %u at 0x%X for %s", custom_switch.value, request.custom_switch_message.value(), address.c_str());
+                messages.push_back(custom_switch);
+                ESP_LOGI(TAG, "Pushing custom switch %u at 0x%X for %s", custom_switch.value, request.custom_switch_message.value(), address_to_string(address).c_str());
             }
 
             if (request.custom_number_message && request.custom_number_value)
             {
                 MessageSet custom_number((MessageNumber)request.custom_number_message.value());
                 custom_number.value = (long)(request.custom_number_value.value());  // Use raw value - scaling handled by multiply option
-                packet.messages.push_back(custom_number);
-                ESP_LOGI(TAG, "Pushing custom number %ld at 0x%X for %s", custom_number.value, request.custom_number_message.value(), address.c_str());
+                messages.push_back(custom_number);
+                ESP_LOGI(TAG, "Pushing custom number %ld at 0x%X for %s", custom_number.value, request.custom_number_message.value(), address_to_string(address).c_str());
             }
+        }
 
-            if (packet.messages.size() == 0)
+        // Sends the messages right away when possible, otherwise they wait in pending_requests.
+        static void request_nasa_messages(MessageTarget *target, PackedAddress address, std::vector<MessageSet> &messages, bool broadcast)
+        {
+            DecoderContext &context = target->get_decoder_context();
+            if (context.request_settle_window == 0 && context.requests.size() < MAX_REQUESTS_IN_FLIGHT)
+            {
+                send_nasa_request(context, target, address, messages, broadcast);
                 return;
+            }
 
-            ESP_LOGW(TAG, "publish packet %s", packet.to_string().c_str());
+            // Rapid changes (e.g. dragging a slider) are collected until the device settled
+            // and go out as one packet, the latest value of every message wins.
+            const uint32_t now = target->get_miliseconds();
+            auto inserted = context.pending_requests.insert({address, PendingNasaRequest()});
+            PendingNasaRequest &pending = inserted.first->second;
+            if (inserted.second)
+            {
+                pending.first_change = now;
+                pending.broadcast = broadcast;
+            }
+
+            for (auto &message : messages)
+            {
+                for (auto it = pending.messages.begin(); it != pending.messages.end(); ++it)
+                {
+                    if (it->messageNumber == message.messageNumber)
+                    {
+                        pending.messages.erase(it);
+                        break;
+                    }
+                }
+                pending.messages.push_back(message);
+            }
 
-            out.push_back(packet);
+            // every change restarts the window, but a continuous stream of changes is not held back forever
+            pending.deadline = now + context.request_settle_window;
+            const uint32_t latest = pending.first_change + context.request_settle_window * MAX_SETTLE_WINDOWS;
+            if ((int32_t)(pending.deadline - latest) > 0)
+                pending.deadline = latest;
+        }
 
-            auto data = packet.encode();
-            target->publish_data(data);
+        void publish_nasa_broadcast(MessageTarget *target, PackedAddress address, ProtocolRequest &request)
+        {
+            std::vector<MessageSet> messages;
+            request_to_messages(address, request, messages);
+            if (messages.size() > 0)
+                request_nasa_messages(target, address, messages, true);
+        }
+
+        void NasaProtocol::publish_request(MessageTarget *target, PackedAddress address, ProtocolRequest &request)
+        {
+            std::vector<MessageSet> messages;
+            request_to_messages(address, request, messages);
+            if (messages.size() > 0)
+                request_nasa_messages(target, address, messages, false);
         }
 
         Mode operation_mode_to_mode(int value)
@@ -520,7 +677,7 @@ namespace esphome
             }
         }
         
-        void process_messageset(std::string source, std::string dest, MessageSet &message, optional<std::set<uint16_t>> &custom, optional<std::set<uint16_t>> &custom_switches, optional<std::set<uint16_t>> &custom_numbers, MessageTarget *target)
+        void process_messageset(PackedAddress source, PackedAddress dest, MessageSet &message, MessageTarget *target)
         {
             if (debug_mqtt_connected())
             {
@@ -538,678 +695,278 @@ namespace esphome
                 }
             }
             
-            if (custom && custom.value().find((uint16_t)message.messageNumber) != custom.value().end())
-            {
-                float value = (float)message.value;
-
-                target->set_custom_sensor(source, (uint16_t)message.messageNumber, value);
-            }
-            
-            if (custom_switches && custom_switches.value().find((uint16_t)message.messageNumber) != custom_switches.value().end())
-            {
-                target->set_custom_switch(source, (uint16_t)message.messageNumber, message.value != 0);
-            }
-            
-            if (custom_numbers && custom_numbers.value().find((uint16_t)message.messageNumber) != custom_numbers.value().end())
-            {
-                target->set_custom_number(source, (uint16_t)message.messageNumber, (float)message.value);  // Use raw value - scaling handled by multiply option
-            }
-            
-            target->getValueForCustomClimate(source, (int16_t) message.messageNumber, message.value);
+            target->dispatch_message(source, (uint16_t)message.messageNumber, message.value); // scaling is done by the entities
 
-            switch (message.messageNumber)
-            {
+            PollTable &polls = target->get_decoder_context().polls;
+            if (!polls.empty())
+                polls.seen(source, (uint16_t)message.messageNumber, target->get_miliseconds());
 
-            case MessageNumber::ENUM_in_state_humidity_percent:
-            {
-                // XML Enum no value but in Code it adds unit
-                ESP_LOGW(TAG, "s:%s d:%s ENUM_in_state_humidity_percent %li", source.c_str(), dest.c_str(), message.value);
+            MessageInfo info;
+            if (!find_message_info((uint16_t)message.messageNumber, info) || info.handler == MessageHandler::None)
                 return;
-            }
 
-            case MessageNumber::ENUM_in_operation_mode:
-            {
-                ESP_LOGW(TAG, "s:%s d:%s ENUM_in_operation_mode %li", source.c_str(), dest.c_str(), message.value);
-                target->set_mode(source, operation_mode_to_mode(message.value));
-                return;
-            }
-            case MessageNumber::ENUM_in_fan_mode:
-            {
-                ESP_LOGW(TAG, "s:%s d:%s ENUM_in_fan_mode %li", source.c_str(), dest.c_str(), message.value);
-                return;
-            }
-            case MessageNumber::ENUM_in_fan_mode_real:
-            {
-                ESP_LOGW(TAG, "s:%s d:%s ENUM_in_fan_mode_real %li", source.c_str(), dest.c_str(), message.value);
-                return;
-            }
-            case MessageNumber::ENUM_in_alt_mode:
-            {
-                ESP_LOGW(TAG, "s:%s d:%s ENUM_in_alt_mode %li", source.c_str(), dest.c_str(), message.value);
-                return;
-            }
-            case MessageNumber::ENUM_in_louver_hl_swing:
-            {
-                ESP_LOGW(TAG, "s:%s d:%s ENUM_in_louver_hl_swing %li", source.c_str(), dest.c_str(), message.value);
-                return;
-            }
-            case MessageNumber::ENUM_in_louver_lr_swing:
-            {
-                ESP_LOGW(TAG, "s:%s d:%s ENUM_in_louver_lr_swing %li", source.c_str(), dest.c_str(), message.value);
-                return;
-            }
-            case MessageNumber::VAR_in_temp_water_tank_f:
+            char name[48];
+            get_message_name(info, name, sizeof(name));
+            const char *unit = message_unit_to_string(info.unit);
+            if (info.scale == MessageScale::None)
             {
-                ESP_LOGW(TAG, "s:%s d:%s VAR_in_temp_water_tank_f %f", source.c_str(), dest.c_str(), message.value);
-                return;
+                ESP_LOGW(TAG, "s:%s d:%s %s %.0f%s", address_to_string(source).c_str(), address_to_string(dest).c_str(), name, get_message_value(info, message.value), unit);
             }
-            case MessageNumber::VAR_out_sensor_airout:
+            else
             {
-                double temp = (double)((int16_t)message.value) / (double)10;
-                ESP_LOGW(TAG, "s:%s d:%s VAR_out_sensor_airout %li", source.c_str(), dest.c_str(), message.value);
-                return;
+                ESP_LOGW(TAG, "s:%s d:%s %s %f%s", address_to_string(source).c_str(), address_to_string(dest).c_str(), name, get_message_value(info, message.value), unit);
             }
 
-            default:
-            {
-                if ((uint16_t)message.messageNumber == 0x4065)
-                {
-                    // ENUM_IN_WATER_HEATER_POWER
-                    ESP_LOGW(TAG, "s:%s d:%s ENUM_IN_WATER_HEATER_POWER %s", source.c_str(), dest.c_str(), message.value == 0 ? "off" : "on");
-                    return;
-                }
-                if ((uint16_t)message.messageNumber == 0x4260)
-                {
-                    // VAR_IN_FSV_3021
-                    double temp = (double)message.value / (double)10;
-                    ESP_LOGW(TAG, "s:%s d:%s VAR_IN_FSV_3021 %f", source.c_str(), dest.c_str(), temp);
-                    return;
-                }
-                if ((uint16_t)message.messageNumber == 0x4261)
-                {
-                    // VAR_IN_FSV_3022
-                    double temp = (double)message.value / (double)10;
-                    ESP_LOGW(TAG, "s:%s d:%s VAR_IN_FSV_3022 %f", source.c_str(), dest.c_str(), temp);
-                    return;
-                }
-                if ((uint16_t)message.messageNumber == 0x4262)
-                {
-                    // VAR_IN_FSV_3023
-                    double temp = (double)message.value / (double)10;
-                    ESP_LOGW(TAG, "s:%s d:%s VAR_IN_FSV_3023 %f", source.c_str(), dest.c_str(), temp);
-                    return;
-                }
-
-                if ((uint16_t)message.messageNumber == 0x8414)
-                {
-                    //  LVAR_OUT_CONTROL_WATTMETER_ALL_UNIT_ACCUM
-                    double kwh = (double)message.value / (double)1000;
-                    ESP_LOGW(TAG, "s:%s d:%s LVAR_OUT_CONTROL_WATTMETER_ALL_UNIT_ACCUM %fkwh", source.c_str(), dest.c_str(), kwh);
-                    return;
-                }
-                if ((uint16_t)message.messageNumber == 0x8413)
-                {
-                    //  LVAR_OUT_CONTROL_WATTMETER_1W_1MIN_SUM
-                    double value = (double)message.value;
-                    ESP_LOGW(TAG, "s:%s d:%s LVAR_OUT_CONTROL_WATTMETER_1W_1MIN_SUM %f", source.c_str(), dest.c_str(), value);
-                    return;
-                }
-                if ((uint16_t)message.messageNumber == 0x8411)
-                {
-                    double value = (double)message.value;
-                    ESP_LOGW(TAG, "s:%s d:%s NASA_OUTDOOR_CONTROL_WATTMETER_1UNIT  %f", source.c_str(), dest.c_str(), value);
-                    return;
-                }
-                if ((uint16_t)message.messageNumber == 0x8427)
-                {
-                    double value = (double)message.value;
-                    ESP_LOGW(TAG, "s:%s d:%s total produced energy  %f", source.c_str(), dest.c_str(), value);
-                    return;
-                }
-                if ((uint16_t)message.messageNumber == 0x8426)
-                {
-                    double value = (double)message.value;
-                    ESP_LOGW(TAG, "s:%s d:%s actual produced energy %f", source.c_str(), dest.c_str(), value);
-                    return;
-                }
-                if ((uint16_t)message.messageNumber == 0x8415)
-                {
-                    double value = (double)message.value;
-                    ESP_LOGW(TAG, "s:%s d:%s NASA_OUTDOOR_CONTROL_WATTMETER_TOTAL_SUM %f", source.c_str(), dest.c_str(), value);
-                    return;
-                }
-                if ((uint16_t)message.messageNumber == 0x8416)
-                {
-                    double value = (double)message.value;
-                    ESP_LOGW(TAG, "s:%s d:%s NASA_OUTDOOR_CONTROL_WATTMETER_TOTAL_SUM_ACCUM %f", source.c_str(), dest.c_str(), value);
-                    return;
-                }
-            }
-            }
+            if (info.handler == MessageHandler::OperationMode)
+                target->set_mode(source, operation_mode_to_mode(message.value));
         }
 
-        DecodeResult try_decode_nasa_packet(std::vector<uint8_t> data)
+        DecodeResult try_decode_nasa_packet(DecoderContext &context, const uint8_t *data, size_t size, bool crc_checked)
         {
-            return packet_.decode(data);
+            // the messages are decoded lazily by process_nasa_packet
+            const DecodeResult result = context.packet.decode_header(data, size, crc_checked);
+            context.frame = result == DecodeResult::Ok ? data : nullptr;
+            context.frame_size = result == DecodeResult::Ok ? size : 0;
+            return result;
         }
 
-        void process_nasa_packet(MessageTarget *target)
+        bool is_filtered_nasa_packet(DecoderContext &context)
         {
-            const auto source = packet_.sa.to_string();
-            const auto dest = packet_.da.to_string();
-
-            target->register_address(source);
-
-            if (debug_log_packets)
-            {
-                ESP_LOGW(TAG, "MSG: %s", packet_.to_string().c_str());
-            }
-
-            for (auto& dn : Samsung_AC_NumberDebug::elements) {
-                for (int i = 0; i < packet_.messages.size(); i++){
-                    MessageSet ms = packet_.messages[i];
-                    auto addr = long_to_hex((uint16_t)ms.messageNumber);
-                    if (dn->targetValue == ms.value && ms.type != Structure && dn->targetValue != Samsung_AC_NumberDebug::UNUSED) {
-                        if (dn->source == packet_.sa.to_string() || dn->source == ""){
-                            std::string str;
-                            str += "#Packet Src:" + packet_.sa.to_string() + " Dst:" + packet_.da.to_string() + " " + packet_.command.to_string() + " value " + ms.to_string() ;
-                            ESP_LOGW(TAG, "\033[1;36mDebugNumber : %s", str.c_str());
-                        }
-                    }
-                }
-            }
-
-            if (packet_.command.dataType == DataType::Ack)
-            {
-                for (int i = 0; i < out.size(); i++)
-                {
-                    if (out[i].command.packetNumber == packet_.command.packetNumber)
-                    {
-                        ESP_LOGW(TAG, "found %d", out[i].command.packetNumber);
-                        out.erase(out.begin() + i);
-                        break;
-                    }
-                }
+            if (!context.filter_unconfigured)
+                return false;
+
+            const PackedAddress source = context.packet.sa.to_packed();
+            const PackedAddress dest = context.packet.da.to_packed();
+            const auto &configured = context.configured_addresses;
+            if (dest == Address::get_my_address().to_packed() ||
+                std::binary_search(configured.begin(), configured.end(), source) ||
+                std::binary_search(configured.begin(), configured.end(), dest))
+                return false;
+
+            context.filtered_frames++;
+            return context.discovery_sample_rate == 0 || context.filtered_frames % context.discovery_sample_rate != 0;
+        }
 
-                ESP_LOGW(TAG, "Ack %s s %d", packet_.to_string().c_str(), out.size());
-                return;
-            }
+        bool is_duplicate_nasa_packet(DecoderContext &context, const uint8_t *data, size_t size, uint32_t now)
+        {
+            // only notifications repeat, everything else has to be processed every time
+            if (context.packet.command.dataType != DataType::Notification)
+                return false;
 
-            if (packet_.command.dataType == DataType::Request)
-            {
-                ESP_LOGW(TAG, "Request %s", packet_.to_string().c_str());
-                return;
-            }
-            if (packet_.command.dataType == DataType::Response)
-            {
-                ESP_LOGW(TAG, "Response %s", packet_.to_string().c_str());
-                return;
-            }
-            if (packet_.command.dataType == DataType::Write)
-            {
-                ESP_LOGW(TAG, "Write %s", packet_.to_string().c_str());
-                return;
-            }
-            if (packet_.command.dataType == DataType::Nack)
+            // FNV-1a over destination, command (without the packet number, which changes
+            // with every frame), capacity and the first message number
+            static const uint8_t header_bytes[] = {6, 7, 8, 9, 10, 12, 13, 14};
+            uint32_t header_hash = 2166136261U;
+            for (uint8_t index : header_bytes)
             {
-                ESP_LOGW(TAG, "Nack %s", packet_.to_string().c_str());
-                return;
-            }
-            if (packet_.command.dataType == DataType::Read)
-            {
-                ESP_LOGW(TAG, "Read %s", packet_.to_string().c_str());
-                return;
+                header_hash = (header_hash ^ data[index]) * 16777619U;
             }
 
-            if (packet_.command.dataType != DataType::Notification)
-                return;
-
-            optional<std::set<uint16_t>> custom = target->get_custom_sensors(source);
-            optional<std::set<uint16_t>> custom_switches = target->get_custom_switches(source);
-            optional<std::set<uint16_t>> custom_numbers = target->get_custom_numbers(source);
-            for (auto &message : packet_.messages)
-            {
-                process_messageset(source, dest, message, custom, custom_switches, custom_numbers, target);
-            }
+            // the frame crc covers the packet number too, so the messages get their own
+            const uint16_t crc = crc16(data + 12, size - 15);
+            return context.duplicates.check(context.packet.sa.to_packed(), header_hash, size, crc, now);
         }
 
-        void process_messageset_debug(std::string source, std::string dest, MessageSet &message, MessageTarget *target)
+        // Messages without subscribers and without a handler are skipped without decoding them.
+        bool is_message_needed(PackedAddress source, uint16_t number, MessageTarget *target)
         {
-            if (source == "20.00.00" ||
-                source == "20.00.01" ||
-                source == "20.00.03")
-                return;
-            if (((uint16_t)message.messageNumber) == 0x4003)
-            {
-                ESP_LOGW(TAG, "s:%s d:%s ENUM_IN_OPERATION_VENT_POWER %li", source.c_str(), dest.c_str(), message.value);
-                return;
-            }
-            if (((uint16_t)message.messageNumber) == 0x4004)
-            {
-                ESP_LOGW(TAG, "s:%s d:%s ENUM_IN_OPERATION_VENT_MODE %li", source.c_str(), dest.c_str(), message.value);
-                return;
-            }
-            if (((uint16_t)message.messageNumber) == 0x4011)
-            {
-                ESP_LOGW(TAG, "s:%s d:%s ENUM_IN_LOUVER_HL_SWING %li", source.c_str(), dest.c_str(), message.value);
-                return;
-            }
-            if (((uint16_t)message.messageNumber) == 0x4012)
-            {
-                ESP_LOGW(TAG, "s:%s d:%s ENUM_in_louver_hl_part_swing %li", source.c_str(), dest.c_str(), message.value);
-                return;
-            }
-            if (((uint16_t)message.messageNumber) == 0x4060)
-            {
-                ESP_LOGW(TAG, "s:%s d:%s ENUM_IN_ALTERNATIVE_MODE %li", source.c_str(), dest.c_str(), message.value);
-                return;
-            }
-            if (((uint16_t)message.messageNumber) == 0x406E)
-            {
-                ESP_LOGW(TAG, "s:%s d:%s ENUM_IN_QUIET_MODE %li", source.c_str(), dest.c_str(), message.value);
-                return;
-            }
-            if (((uint16_t)message.messageNumber) == 0x4119)
-            {
-                ESP_LOGW(TAG, "s:%s d:%s ENUM_IN_OPERATION_POWER_ZONE1 %li", source.c_str(), dest.c_str(), message.value);
-                return;
-            }
-            if (((uint16_t)message.messageNumber) == 0x411E)
-            {
-                ESP_LOGW(TAG, "s:%s d:%s ENUM_IN_OPERATION_POWER_ZONE2 %li", source.c_str(), dest.c_str(), message.value);
-                return;
-            }
+            if (target->is_subscribed(source, number))
+                return true;
 
-            return;
-
-            switch ((uint16_t)message.messageNumber)
-            {
-            case 0x4002: // ENUM_in_operation_mode_real
-            {
-                // Todo Map
-                ESP_LOGW(TAG, "s:%s d:%s ENUM_in_operation_mode_real %li", source.c_str(), dest.c_str(), message.value);
-                return;
-            }
-
-            case 0x4008: // ENUM_in_fan_vent_mode
-            {
-                ESP_LOGW(TAG, "s:%s d:%s ENUM_in_fan_vent_mode %li", source.c_str(), dest.c_str(), message.value);
-                // fan_vent_mode_to_fanmode();
-                return;
-            }
-
-            case 0x4011: // ENUM_IN_LOUVER_HL_SWING
-            {
-                // Todo Map
-                /*
-               case 0:
-    return 'Off';
-    case 1:
-    return 'On';
-    default:
-    return undefined;
-                */
-                ESP_LOGW(TAG, "s:%s d:%s ENUM_IN_LOUVER_HL_SWING %li", source.c_str(), dest.c_str(), message.value);
-                return;
-            }
+            MessageInfo info;
+            return find_message_info(number, info) && info.handler != MessageHandler::None;
+        }
 
-            case 0x4012: // ENUM_IN_LOUVER_HL_SWING
-            {
-                // Todo Map
+        void process_nasa_packet(DecoderContext &context, MessageTarget *target)
+        {
+            Packet &packet = context.packet;
+            const PackedAddress source = packet.sa.to_packed();
+            const PackedAddress dest = packet.da.to_packed();
 
-                ESP_LOGW(TAG, "s:%s d:%s ENUM_IN_LOUVER_HL_SWING %li", source.c_str(), dest.c_str(), message.value);
-                return;
-            }
+            target->register_address(source);
 
-            case 0x4205: // VAR_in_temp_eva_in_f unit = 'Celsius'
+            // Notifications are the bulk of the traffic, their messages are only decoded
+            // one by one as needed. Everything which logs whole packets needs them all.
+            // Responses (to our polls) carry values just like notifications.
+            const bool carries_values = packet.command.dataType == DataType::Notification || packet.command.dataType == DataType::Response;
+            const bool materialize = context.debug_log_packets || !Samsung_AC_NumberDebug::elements.empty() || !carries_values;
+            if (materialize && packet.decode_messages(context.frame, context.frame_size) != DecodeResult::Ok)
             {
-                double temp = (double)message.value / (double)10;
-                ESP_LOGW(TAG, "s:%s d:%s VAR_in_temp_eva_in_f %f", source.c_str(), dest.c_str(), temp);
+                ESP_LOGV(TAG, "invalid message set: %s", bytes_to_hex(context.frame, context.frame_size).c_str());
                 return;
             }
 
-            case 0x4206: // VAR_in_temp_eva_out_f unit = 'Celsius'
+            if (context.debug_log_packets)
             {
-                double temp = (double)message.value / (double)10;
-                ESP_LOGW(TAG, "s:%s d:%s VAR_in_temp_eva_out_f %f", source.c_str(), dest.c_str(), temp);
-                return;
+                ESP_LOGW(TAG, "MSG: %s", packet.to_string().c_str());
             }
 
-            case 0x4211: // VAR_in_capacity_request unit = 'kW'
-            {
-                double temp = (double)message.value / (double)8.6;
-                ESP_LOGW(TAG, "s:%s d:%s VAR_in_capacity_request %f", source.c_str(), dest.c_str(), temp);
-                return;
+            for (auto& dn : Samsung_AC_NumberDebug::elements) {
+                for (int i = 0; i < packet.messages.size(); i++){
+                    MessageSet ms = packet.messages[i];
+                    auto addr = long_to_hex((uint16_t)ms.messageNumber);
+                    if (dn->targetValue == ms.value && ms.type != Structure && dn->targetValue != Samsung_AC_NumberDebug::UNUSED) {
+                        if (dn->source == packet.sa.to_string() || dn->source == ""){
+                            std::string str;
+                            str += "#Packet Src:" + packet.sa.to_string() + " Dst:" + packet.da.to_string() + " " + packet.command.to_string() + " value " + ms.to_string() ;
+                            ESP_LOGW(TAG, "\033[1;36mDebugNumber : %s", str.c_str());
+                        }
+                    }
+                }
             }
 
-            case 0x8001: // ENUM_out_operation_odu_mode
+            if (packet.command.dataType == DataType::Ack)
             {
-                // Todo Map
-                ESP_LOGW(TAG, "s:%s d:%s ENUM_out_operation_odu_mode %li", source.c_str(), dest.c_str(), message.value);
-                return;
-            }
+                if (context.requests.acknowledge(packet.command.packetNumber, packet.sa.to_packed(), packet.da.to_packed(), target->get_frame_received_miliseconds()))
+                    ESP_LOGW(TAG, "found %d", packet.command.packetNumber);
 
-            case 0x8003: // ENUM_out_operation_heatcool
-            {
-                //['Undefined', 'Cool', 'Heat', 'CoolMain', 'HeatMain'];
-                // Todo Map
-                ESP_LOGW(TAG, "s:%s d:%s ENUM_out_operation_heatcool %li", source.c_str(), dest.c_str(), message.value);
+                ESP_LOGW(TAG, "Ack %s s %d", packet.to_string().c_str(), context.requests.size());
                 return;
             }
 
-            case 0x801a: // ENUM_out_load_4way
+            if (packet.command.dataType == DataType::Request)
             {
-                ESP_LOGW(TAG, "s:%s d:%s ENUM_out_load_4way %li", source.c_str(), dest.c_str(), message.value);
+                ESP_LOGW(TAG, "Request %s", packet.to_string().c_str());
                 return;
             }
-
-            case 0x8235: // VAR_out_error_code
+            if (packet.command.dataType == DataType::Write)
             {
-                ESP_LOGW(TAG, "s:%s d:%s VAR_out_error_code %li", source.c_str(), dest.c_str(), message.value);
+                ESP_LOGW(TAG, "Write %s", packet.to_string().c_str());
                 return;
             }
-
-            case 0x8261: // VAR_OUT_SENSOR_PIPEIN3 unit = 'Celsius'
+            if (packet.command.dataType == DataType::Nack)
             {
-                double temp = (double)message.value / (double)10;
-                ESP_LOGW(TAG, "s:%s d:%s VAR_OUT_SENSOR_PIPEIN3 %f", source.c_str(), dest.c_str(), temp);
+                ESP_LOGW(TAG, "Nack %s", packet.to_string().c_str());
                 return;
             }
-
-            case 0x8262: // VAR_OUT_SENSOR_PIPEIN4 unit = 'Celsius'
+            if (packet.command.dataType == DataType::Read)
             {
-                double temp = (double)message.value / (double)10;
-                ESP_LOGW(TAG, "s:%s d:%s VAR_OUT_SENSOR_PIPEIN4 %f", source.c_str(), dest.c_str(), temp);
+                ESP_LOGW(TAG, "Read %s", packet.to_string().c_str());
                 return;
             }
 
-            case 0x8263: // VAR_OUT_SENSOR_PIPEIN5 unit = 'Celsius'
-            {
-                double temp = (double)message.value / (double)10;
-                ESP_LOGW(TAG, "s:%s d:%s VAR_OUT_SENSOR_PIPEIN5 %f", source.c_str(), dest.c_str(), temp);
+            if (!carries_values)
                 return;
-            }
 
-            case 0x8264: // VAR_OUT_SENSOR_PIPEOUT1 unit = 'Celsius'
+            if (materialize)
             {
-                double temp = (double)message.value / (double)10;
-                ESP_LOGW(TAG, "s:%s d:%s VAR_OUT_SENSOR_PIPEOUT1 %f", source.c_str(), dest.c_str(), temp);
+                for (auto &message : packet.messages)
+                {
+                    process_messageset(source, dest, message, target);
+                }
                 return;
             }
 
-            case 0x8265: // VAR_OUT_SENSOR_PIPEOUT2 unit = 'Celsius'
+            const bool publish_all = debug_mqtt_connected();
+            MessageSetIterator iterator(context.frame, context.frame_size);
+            MessageSetView view;
+            while (iterator.next(view))
             {
-                double temp = (double)message.value / (double)10;
-                ESP_LOGW(TAG, "s:%s d:%s VAR_OUT_SENSOR_PIPEOUT2 %f", source.c_str(), dest.c_str(), temp);
-                return;
-            }
+                if (!publish_all && !is_message_needed(source, view.number, target))
+                    continue;
 
-            case 0x8266: // VAR_OUT_SENSOR_PIPEOUT3 unit = 'Celsius'
-            {
-                double temp = (double)message.value / (double)10;
-                ESP_LOGW(TAG, "s:%s d:%s VAR_OUT_SENSOR_PIPEOUT3 %f", source.c_str(), dest.c_str(), temp);
-                return;
+                MessageSet message = view.to_message_set();
+                process_messageset(source, dest, message, target);
             }
 
-            case 0x8267: // VAR_OUT_SENSOR_PIPEOUT4 unit = 'Celsius'
+            if (iterator.failed())
             {
-                double temp = (double)message.value / (double)10;
-                ESP_LOGW(TAG, "s:%s d:%s VAR_OUT_SENSOR_PIPEOUT4 %f", source.c_str(), dest.c_str(), temp);
-                return;
+                ESP_LOGV(TAG, "invalid message set: %s", bytes_to_hex(context.frame, context.frame_size).c_str());
             }
+        }
 
-            case 0x8268: // VAR_OUT_SENSOR_PIPEOUT5 unit = 'Celsius'
-            {
-                double temp = (double)message.value / (double)10;
-                ESP_LOGW(TAG, "s:%s d:%s VAR_OUT_SENSOR_PIPEOUT5 %f", source.c_str(), dest.c_str(), temp);
-                return;
-            }
+        // Returns false when the send queue is full.
+        bool send_nasa_read(DecoderContext &context, MessageTarget *target, Packet &packet)
+        {
+            packet.command.packetNumber = context.packet_counter++;
+            if (context.debug_log_packets)
+                ESP_LOGW(TAG, "poll %s", packet.to_string().c_str());
 
-            case 0x8274: // VAR_out_control_order_cfreq_comp2
-            {
-                ESP_LOGW(TAG, "s:%s d:%s VAR_out_control_order_cfreq_comp2 %li", source.c_str(), dest.c_str(), message.value);
-                return;
-            }
-            case 0x8275: // VAR_out_control_target_cfreq_comp2
-            {
-                ESP_LOGW(TAG, "s:%s d:%s VAR_out_control_target_cfreq_comp2 %li", source.c_str(), dest.c_str(), message.value);
-                return;
-            }
+            auto data = packet.encode();
+            packet.messages.clear();
+            return target->queue_data(data, TxPriority::Poll);
+        }
 
-            case 0x82bc: // VAR_OUT_PROJECT_CODE
+        // The due entries in [first, last) were asked for, they are due again after their interval.
+        static void advance_polled(std::vector<PollTable::Entry> &entries, size_t first, size_t last, uint32_t now)
+        {
+            for (size_t i = first; i < last; i++)
             {
-                ESP_LOGW(TAG, "s:%s d:%s VAR_OUT_PROJECT_CODE %li", source.c_str(), dest.c_str(), message.value);
-                return;
+                if ((int32_t)(now - entries[i].next_due) >= 0)
+                    entries[i].next_due = now + entries[i].interval;
             }
+        }
 
-            case 0x82e3: // VAR_OUT_PRODUCT_OPTION_CAPA
-            {
-                ESP_LOGW(TAG, "s:%s d:%s VAR_OUT_PRODUCT_OPTION_CAPA %li", source.c_str(), dest.c_str(), message.value);
+        void poll_nasa_messages(DecoderContext &context, MessageTarget *target, uint32_t now)
+        {
+            PollTable &polls = context.polls;
+            if (!polls.empty() && !polls.scheduled())
+                polls.schedule(now);
+            if (!polls.any_due(now))
                 return;
-            }
 
-            case 0x8280: // VAR_out_sensor_top1 unit = 'Celsius'
+            // a full send queue ends the pass, what was not queued stays due
+            auto &entries = polls.entries();
+            size_t i = 0;
+            bool queued = true;
+            while (queued && i < entries.size())
             {
-                double temp = (double)message.value / (double)10;
-                ESP_LOGW(TAG, "s:%s d:%s VAR_out_sensor_top1 %f", source.c_str(), dest.c_str(), temp);
-                return;
-            }
+                const PackedAddress destination = entries[i].destination();
+                Packet packet = Packet::createa_partial(Address::from_packed(destination), DataType::Read);
+                // start byte, size, addresses, command, capacity, checksum and end byte
+                uint16_t size = 16;
+                size_t first = i;
 
-            case 0x82db: // VAR_OUT_PHASE_CURRENT
-            {
-                ESP_LOGW(TAG, "s:%s d:%s VAR_OUT_PHASE_CURRENT %li", source.c_str(), dest.c_str(), message.value);
-                return;
-            }
+                for (; i < entries.size() && entries[i].destination() == destination; i++)
+                {
+                    PollTable::Entry &entry = entries[i];
+                    if ((int32_t)(now - entry.next_due) < 0)
+                        continue;
 
-            case 0x402:
-            case 0x409:
-            case 0x40a:
-            case 0x40b:
-            case 0x40c:
-            case 0x40d:
-            case 0x40e:
-            case 0x410:
-            case 0x411:
-            case 0x412:
-            case 0x413:
-            case 0x414:
-            case 0x415:
-            case 0x416:
-            case 0x601:
-            case 0x207:
-            case 0x41b:
-            case 0x60c:
-            case 0x24fb:
-            case 0x4015:
-            case 0x4016:
-            case 0x401b:
-            case 0x4023:
-            case 0x4024:
-            case 0x4027:
-            case 0x4028:
-            case 0x402d:
-            case 0x402e:
-            case 0x4035:
-            case 0x403e:
-            case 0x403f:
-            case 0x4043:
-            case 0x4045:
-            case 0x4046:
-            case 0x4047:
-            case 0x4048:
-            case 0x4059:
-            case 0x4060:
-            case 0x4074:
-            case 0x407d:
-            case 0x407e:
-            case 0x40ae:
-            case 0x40af:
-            case 0x40bc:
-            case 0x40bd:
-            case 0x40d5:
-            case 0x410a:
-            case 0x410b:
-            case 0x410c:
-            case 0x4111:
-            case 0x4112:
-            case 0x42df:
-            case 0x4604:
-            case 0x80af:
-            case 0x8204:
-            case 0x820a:
-            case 0x8217:
-            case 0x8218:
-            case 0x821a:
-            case 0x8223:
-            case 0x4212:
-            case 0x4222:
-            case 0x4229:
-            case 0x42e0:
-            case 0x8229:
-            case 0x822a:
-            case 0x822b:
-            case 0x822c:
-            case 0x8233:
-            case 0x8236:
-            case 0x8237:
-            case 0x8238:
-            case 0x8239:
-            case 0x823b:
-            case 0x823d:
-            case 0x42e3:
-            case 0x42e5:
-            case 0x440e:
-            case 0x440f:
-            case 0x4418:
-            case 0x441b:
-            case 0x441f:
-            case 0x4420:
-            case 0x4423:
-            case 0x4424:
-            case 0x8000:
-            case 0x8002:
-            case 0x800d:
-            case 0x8010:
-            case 0x8020:
-            case 0x8030:
-            case 0x8032:
-            case 0x8033:
-            case 0x8043:
-            case 0x8045:
-            case 0x8046:
-            case 0x8048:
-            case 0x8061:
-            case 0x8066:
-            case 0x8077:
-            case 0x807c:
-            case 0x807d:
-            case 0x807e:
-            case 0x8081:
-            case 0x808c:
-            case 0x808e:
-            case 0x808f:
-            case 0x809d:
-            case 0x8047:
-            case 0x8200:
-            case 0x8201:
-            case 0x8202:
-            case 0x822d:
-            case 0x8287:
-            case 0x82a1:
-            case 0x82b5:
-            case 0x82b6:
-            case 0x8411:
-            case 0x8413:
-            case 0x8414:
-            case 0x8608:
-            case 0x860c:
-            case 0x860d:
-            case 0x840a:
-            case 0x8410:
-            case 0x823e:
-            case 0x8247:
-            case 0x8249:
-            case 0x824b:
-            case 0x824c:
-            case 0x824f:
-            case 0x8254:
-            case 0x825f:
-            case 0x8260:
-            case 0x2400:
-            case 0x2401:
-            case 0x24fc:
-            {
-                // ESP_LOGW(TAG, "s:%s d:%s Todo %s %li", source.c_str(), dest.c_str(), long_to_hex((int)message.messageNumber).c_str(), message.value);
-                return; // Todo
-            }
+                    MessageSet message((MessageNumber)entry.message_number());
+                    if (message.type == Structure)
+                    {
+                        entry.next_due = now + entry.interval;
+                        continue; // the size of the answer is not known up front
+                    }
 
-            case 0x8601: // STR_out_install_inverter_and_bootloader_info
-            case 0x608:  // STR_ad_dbcode_micom_main
-            case 0x603:  // STR_ad_option_cycle
-            case 0x602:  // STR_ad_option_install_2
-            case 0x600:  // STR_ad_option_basic
-            case 0x202:  // VAR_ad_error_code1
-            case 0x42d1: // VAR_IN_DUST_SENSOR_PM10_0_VALUE
-            case 0x42d2: // VAR_IN_DUST_SENSOR_PM2_5_VALUE
-            case 0x42d3: // VAR_IN_DUST_SENSOR_PM1_0_VALUE
-            {
-                // ESP_LOGW(TAG, "s:%s d:%s Ignore %s %li", source.c_str(), dest.c_str(), long_to_hex((int)message.messageNumber).c_str(), message.value);
-                return; // Ingore cause not important
-            }
+                    if (size + message.size() > MAX_POLL_PACKET_SIZE || packet.messages.size() == MAX_MESSAGES_PER_PACKET)
+                    {
+                        queued = send_nasa_read(context, target, packet);
+                        if (!queued)
+                            break;
+                        advance_polled(entries, first, i, now);
+                        first = i;
+                        size = 16;
+                    }
+                    packet.messages.push_back(message);
+                    size += message.size();
+                }
 
-            case 0x23:
-            case 0x61d:
-            case 0x400a:
-            case 0x400f:
-            case 0x42e1:
-            case 0x42e2:
-            case 0x42e4:
-            case 0x22f9:
-            case 0x22fa:
-            case 0x22fb:
-            case 0x22fc:
-            case 0x22fd:
-            case 0x22fe:
-            case 0x22ff:
-            case 0x80a7:
-            case 0x80a8:
-            case 0x80a9:
-            case 0x80aa:
-            case 0x80ab:
-            case 0x80b2:
-            case 0x4285:
-            case 0x429d:
-            case 0x826a:
-            case 0x22f7:
-            case 0x82da:
-            case 0x82d9:
-            case 0x82ee:
-            case 0x82ef:
-            case 0x82e6:
-            case 0x82e5:
-            case 0x82dd:
-            case 0x4202:
-            case 0x82d4:
-            case 0x421c:
-            case 0x8031:
-            case 0x805e:
-            case 0x8243:
-            case 0x803f:
-            case 0x808d:
-            case 0x8248:
-            case 0x823f:
-            case 0x4204:
-            case 0x4006:
-            {
-                // ESP_LOGW(TAG, "s:%s d:%s NoMap %s %li", source.c_str(), dest.c_str(), long_to_hex((int)message.messageNumber).c_str(), message.value);
-                return; // message types witch have no mapping in xml
+                if (queued && !packet.messages.empty())
+                {
+                    queued = send_nasa_read(context, target, packet);
+                    if (queued)
+                        advance_polled(entries, first, i, now);
+                }
             }
 
-            default:
-                ESP_LOGW(TAG, "s:%s d:%s !! unknown %s", source.c_str(), dest.c_str(), message.to_string().c_str());
-            }
-            return;
+            polls.update_next_due();
         }
 
+        void check_nasa_timeouts(DecoderContext &context, MessageTarget *target, uint32_t now)
+        {
+            context.requests.check_timeouts(
+                now,
+                [target](std::vector<uint8_t> &frame)
+                {
+                    ESP_LOGW(TAG, "Request #%d not acknowledged, sending again", frame[11]);
+                    return target->queue_data(frame, TxPriority::Retry);
+                },
+                [](PackedAddress destination, uint8_t packet_number)
+                {
+                    ESP_LOGE(TAG, "Request #%d to %s was never acknowledged", packet_number, address_to_string(destination).c_str());
+                });
+        }
     } // namespace samsung_ac
 } // namespace esphome
@@ -92,9 +92,15 @@ namespace esphome
             uint8_t size = 3;
 
             static Address parse(const std::string &str);
+            static Address from_packed(PackedAddress packed);
             static Address get_my_address();
 
-            void decode(std::vector<uint8_t> &data, unsigned int index);
+            PackedAddress to_packed() const
+            {
+                return (PackedAddress)klass << 16 | (PackedAddress)channel << 8 | address;
+            }
+
+            void decode(const uint8_t *data, unsigned int index);
             void encode(std::vector<uint8_t> &data);
             std::string to_string();
         };
@@ -110,27 +116,27 @@ namespace esphome
 
             uint8_t size = 3;
 
-            void decode(std::vector<uint8_t> &data, unsigned int index);
+            void decode(const uint8_t *data, unsigned int index);
             void encode(std::vector<uint8_t> &data);
             std::string to_string();
         };
 
-        struct Buffer
-        {
-            uint8_t size;
-            uint8_t data[255];
-        };
+        // The capacity field of a packet is a single byte.
+        static const uint16_t MAX_MESSAGES_PER_PACKET = 255;
 
+        // Kept small because packets carry dozens of them: scalar values are stored
+        // inline, structure payloads point into the buffer the message was decoded
+        // from and are only valid as long as that buffer is.
         struct MessageSet
         {
             MessageNumber messageNumber = MessageNumber::Undefiend;
             MessageSetType type = Enum;
+            uint16_t structure_size = 0;
             union
             {
                 long value;
-                Buffer structure;
+                const uint8_t *structure;
             };
-            uint16_t size = 2;
 
             MessageSet(MessageNumber messageNumber)
             {
@@ -138,14 +144,50 @@ namespace esphome
                 // this->deviceType = (NMessageSet.DeviceType) (((int) messageNumber & 57344) >> 13);
                 this->type = (MessageSetType)(((uint32_t)messageNumber & 1536) >> 9);
                 // this->_msgIndex = (ushort) ((uint) messageNumber & 511U);
+                this->value = 0;
             }
 
-            static MessageSet decode(std::vector<uint8_t> &data, unsigned int index, int capacity);
+            // encoded size including the message number
+            uint16_t size() const;
 
             void encode(std::vector<uint8_t> &data);
             std::string to_string();
         };
 
+        // A message set as it is stored in a frame, nothing is decoded or copied.
+        struct MessageSetView
+        {
+            uint16_t number;
+            MessageSetType type;
+            const uint8_t *payload;
+            uint16_t payload_size;
+
+            long value() const;
+            MessageSet to_message_set() const;
+        };
+
+        // Walks the message sets of a frame without decoding them. The type bits
+        // of the message number tell how many bytes to skip to the next one.
+        class MessageSetIterator
+        {
+        public:
+            // data and size describe the whole (valid) frame
+            MessageSetIterator(const uint8_t *data, size_t size);
+
+            // Returns false at the end of the frame or when a message set does not fit into it.
+            bool next(MessageSetView &view);
+            // true when the iteration stopped at a malformed message set
+            bool failed() const { return failed_; }
+
+        protected:
+            const uint8_t *data_;
+            size_t end_;
+            size_t cursor_;
+            uint8_t capacity_;
+            uint8_t remaining_;
+            bool failed_{false};
+        };
+
         struct Packet
         {
             Address sa;
@@ -156,20 +198,58 @@ namespace esphome
             static Packet create(Address da, DataType dataType, MessageNumber messageNumber, int value);
             static Packet createa_partial(Address da, DataType dataType);
 
-            DecodeResult decode(std::vector<uint8_t> &data);
+            // crc_checked skips the checksum validation when the caller (the framer) already did it.
+            DecodeResult decode(const uint8_t *data, size_t size, bool crc_checked = false);
+            // Validates the frame and decodes addresses and command only, messages stays empty.
+            DecodeResult decode_header(const uint8_t *data, size_t size, bool crc_checked = false);
+            // Fills messages from a frame which passed decode_header.
+            DecodeResult decode_messages(const uint8_t *data, size_t size);
             std::vector<uint8_t> encode();
             std::string to_string();
         };
 
-        DecodeResult try_decode_nasa_packet(std::vector<uint8_t> data);
-        void process_nasa_packet(MessageTarget *target);
+        // Control changes of one device which wait for its settle window to close.
+        struct PendingNasaRequest
+        {
+            std::vector<MessageSet> messages;
+            uint32_t first_change = 0;
+            uint32_t deadline = 0;
+            bool broadcast = false; // nobody acknowledges it
+        };
+
+        // Read packets are kept short: the device answers with a frame of about the same
+        // size and both block the bus while they are sent.
+        static const uint16_t MAX_POLL_PACKET_SIZE = 256;
+
+        // A pending request goes out at the latest this many settle windows after its first change.
+        static const uint32_t MAX_SETTLE_WINDOWS = 4;
+
+        // Requests are sent back to back without waiting for their Acks, but at most this many
+        // are unacknowledged at a time (the retransmit table and the send queue are bounded).
+        static const size_t MAX_REQUESTS_IN_FLIGHT = 8;
+
+        DecodeResult try_decode_nasa_packet(DecoderContext &context, const uint8_t *data, size_t size, bool crc_checked);
+        // Checks a packet which passed try_decode_nasa_packet against the address filter of the context.
+        bool is_filtered_nasa_packet(DecoderContext &context);
+        // Checks a packet which passed try_decode_nasa_packet against the duplicate filter of the context.
+        bool is_duplicate_nasa_packet(DecoderContext &context, const uint8_t *data, size_t size, uint32_t now);
+        void process_nasa_packet(DecoderContext &context, MessageTarget *target);
+        // Sends the collected control requests of every device whose settle window closed as one packet.
+        void send_pending_nasa_requests(DecoderContext &context, MessageTarget *target, uint32_t now);
+        // Asks every device for its due polled messages, as few Read packets as possible.
+        void poll_nasa_messages(DecoderContext &context, MessageTarget *target, uint32_t now);
+        // Sends the changes of the request as one packet to a broadcast (or multicast) address,
+        // collected in the settle window like the requests to a single device.
+        void publish_nasa_broadcast(MessageTarget *target, PackedAddress address, ProtocolRequest &request);
+        // Sends unacknowledged requests again once their timeout passed and gives up on them after the retries.
+        void check_nasa_timeouts(DecoderContext &context, MessageTarget *target, uint32_t now);
 
         class NasaProtocol : public Protocol
         {
         public:
             NasaProtocol() = default;
 
-            void publish_request(MessageTarget *target, const std::string &address, ProtocolRequest &request) override;
+            void publish_request(MessageTarget *target, PackedAddress address, ProtocolRequest &request) override;
         };
 
     } // namespace samsung_ac
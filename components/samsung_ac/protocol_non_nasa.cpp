@@ -6,16 +6,13 @@
 #include "esphome/core/hal.h"
 #include "util.h"
 #include "protocol_non_nasa.h"
-
-std::map<std::string, esphome::samsung_ac::NonNasaCommand20> last_command20s_;
-
-esphome::samsung_ac::NonNasaDataPacket nonpacket_;
+#include "decoder_context.h"
 
 namespace esphome
 {
     namespace samsung_ac
     {
-        uint8_t build_checksum(std::vector<uint8_t> &data)
+        uint8_t build_checksum(const uint8_t *data)
         {
             uint8_t sum = data[1];
             for (uint8_t i = 2; i < 12; i++)
@@ -153,22 +150,22 @@ namespace esphome
             return str;
         }
 
-        DecodeResult NonNasaDataPacket::decode(std::vector<uint8_t> &data)
+        DecodeResult NonNasaDataPacket::decode(const uint8_t *data, size_t size)
         {
             if (data[0] != 0x32)
                 return DecodeResult::InvalidStartByte;
 
-            if (data[data.size() - 1] != 0x34)
+            if (data[size - 1] != 0x34)
                 return DecodeResult::InvalidEndByte;
 
-            if (data.size() != 7 && data.size() != 14)
+            if (size != 7 && size != 14)
                 return DecodeResult::UnexpectedSize;
 
             auto crc_expected = build_checksum(data);
-            auto crc_actual = data[data.size() - 2];
+            auto crc_actual = data[size - 2];
             if (crc_actual != build_checksum(data))
             {
-                ESP_LOGW(TAG, "NonNASA: invalid crc - got %d but should be %d: %s", crc_actual, crc_expected, bytes_to_hex(data).c_str());
+                ESP_LOGW(TAG, "NonNASA: invalid crc - got %d but should be %d: %s", crc_actual, crc_expected, bytes_to_hex(data, size).c_str());
                 return DecodeResult::CrcError;
             }
 
@@ -254,9 +251,8 @@ namespace esphome
             }
             default:
             {
-                commandRaw.length = data.size() - 4 - 1;
-                auto begin = data.begin() + 4;
-                std::copy(begin, begin + commandRaw.length, commandRaw.data);
+                commandRaw.length = size - 4 - 1;
+                std::copy(data + 4, data + 4 + commandRaw.length, commandRaw.data);
                 return DecodeResult::Ok;
             }
             }
@@ -335,19 +331,19 @@ namespace esphome
             data[8] = !power ? (uint8_t)0xC0 : (uint8_t)0xF0;
             data[8] |= (individual ? 6U : 4U);
             data[9] = (uint8_t)0x21;
-            data[12] = build_checksum(data);
+            data[12] = build_checksum(data.data());
 
             data[9] = (uint8_t)0x21;
 
             return data;
         }
 
-        NonNasaRequest NonNasaRequest::create(std::string dst_address)
+        NonNasaRequest NonNasaRequest::create(DecoderContext &context, PackedAddress dst_address)
         {
             NonNasaRequest request;
-            request.dst = dst_address;
+            request.dst = address_to_string(dst_address);
 
-            auto last_command20_ = last_command20s_[dst_address];
+            auto last_command20_ = context.last_command20s[dst_address];
             request.room_temp = last_command20_.room_temp;
             request.power = last_command20_.power;
             request.target_temp = last_command20_.target_temp;
@@ -357,8 +353,6 @@ namespace esphome
             return request;
         }
 
-        std::queue<NonNasaRequest> nonnasa_requests;
-
         NonNasaMode mode_to_nonnasa_mode(Mode value)
         {
             switch (value)
@@ -394,9 +388,10 @@ namespace esphome
             }
         }
 
-        void NonNasaProtocol::publish_request(MessageTarget *target, const std::string &address, ProtocolRequest &request)
+        void NonNasaProtocol::publish_request(MessageTarget *target, PackedAddress address, ProtocolRequest &request)
         {
-            auto req = NonNasaRequest::create(address);
+            DecoderContext &context = target->get_decoder_context();
+            auto req = NonNasaRequest::create(context, address);
             if (request.caller.has_value()) {
                 ESP_LOGE(TAG, "Custom Climate not supported by non nasa devices");
                 return;
@@ -439,7 +434,7 @@ namespace esphome
                 return;
             }
 
-            nonnasa_requests.push(req);
+            context.nonnasa_requests.push(req);
         }
 
         Mode nonnasa_mode_to_mode(NonNasaMode value)
@@ -479,57 +474,89 @@ namespace esphome
             }
         }
 
-        DecodeResult try_decode_non_nasa_packet(std::vector<uint8_t> data)
+        // Cheap check used by the framer. Does the same validation as NonNasaDataPacket::decode
+        // but without decoding or logging anything.
+        bool is_non_nasa_packet(const uint8_t *data, size_t size)
+        {
+            if (size != 7 && size != 14)
+                return false;
+
+            return data[0] == 0x32 && data[size - 1] == 0x34 && data[size - 2] == build_checksum(data);
+        }
+
+        DecodeResult try_decode_non_nasa_packet(DecoderContext &context, const uint8_t *data, size_t size)
+        {
+            return context.nonpacket.decode(data, size);
+        }
+
+        void open_send_window(DecoderContext &context, MessageTarget *target)
         {
-            return nonpacket_.decode(data);
+            context.nonnasa_window_open = true;
+            context.nonnasa_window_start = target->get_frame_received_miliseconds();
+            context.nonnasa_last_send = context.nonnasa_window_start;
         }
 
-        void send_requests(MessageTarget *target, uint8_t delay_ms)
+        void send_non_nasa_requests(DecoderContext &context, MessageTarget *target, uint32_t now)
         {
-            while (nonnasa_requests.size() > 0)
+            if (!context.nonnasa_window_open)
+                return;
+
+            if (now - context.nonnasa_window_start >= NON_NASA_WINDOW_CLOSE)
             {
-                delay(delay_ms);
-                auto data = nonnasa_requests.front().encode();
-                target->publish_data(data);
-                nonnasa_requests.pop();
+                context.nonnasa_window_open = false;
+                return;
             }
+
+            auto &nonnasa_requests = context.nonnasa_requests;
+            if (nonnasa_requests.empty() || now - context.nonnasa_last_send < NON_NASA_SEND_DELAY)
+                return;
+
+            auto data = nonnasa_requests.front().encode();
+            // a collided request is sent again in the next slot
+            if (target->publish_data(data))
+                nonnasa_requests.pop();
+            // publish_data returns once the frame is out, the next delay starts then
+            context.nonnasa_last_send = target->get_miliseconds();
         }
 
-        void process_non_nasa_packet(MessageTarget *target)
+        void process_non_nasa_packet(DecoderContext &context, MessageTarget *target)
         {
-            if (debug_log_packets)
+            NonNasaDataPacket &nonpacket = context.nonpacket;
+            const PackedAddress source = parse_address(nonpacket.src);
+
+            if (context.debug_log_packets)
             {
-                ESP_LOGW(TAG, "MSG: %s", nonpacket_.to_string().c_str());
+                ESP_LOGW(TAG, "MSG: %s", nonpacket.to_string().c_str());
             }
 
-            target->register_address(nonpacket_.src);
+            target->register_address(source);
 
-            if (nonpacket_.cmd == NonNasaCommand::Cmd20)
+            if (nonpacket.cmd == NonNasaCommand::Cmd20)
             {
-                last_command20s_[nonpacket_.src] = nonpacket_.command20;
-                target->set_custom_number(nonpacket_.src, 0x4201, nonpacket_.command20.target_temp);
-                target->set_custom_sensor(nonpacket_.src, 0x4203, nonpacket_.command20.room_temp);
-                target->set_custom_switch(nonpacket_.src, 0x4000, nonpacket_.command20.power);
-                target->set_mode(nonpacket_.src, nonnasa_mode_to_mode(nonpacket_.command20.mode));
+                context.last_command20s[source] = nonpacket.command20;
+                target->dispatch_message(source, 0x4201, nonpacket.command20.target_temp);
+                target->dispatch_message(source, 0x4203, nonpacket.command20.room_temp);
+                target->dispatch_message(source, 0x4000, nonpacket.command20.power);
+                target->set_mode(source, nonnasa_mode_to_mode(nonpacket.command20.mode));
                 // Note: fanmode, altmode, and swing methods removed - use custom sensors/switches/numbers for these features
             }
-            else if (nonpacket_.cmd == NonNasaCommand::CmdF8)
+            else if (nonpacket.cmd == NonNasaCommand::CmdF8)
             {
                 // After cmd F8 (src:c8 dst:f0) is a lage gap in communication, time to send data. Some systems did not sent that.
-                if (nonpacket_.src == "c8" && nonpacket_.dst == "f0")
+                if (nonpacket.src == "c8" && nonpacket.dst == "f0")
                 {
                     // the communication needs a delay from cmdf8 to send the data.
                     // series of test-delay-times: 1ms: no reaction, 7ms reactions half the time, 10ms very often a reaction (95%) -> delay on 20ms should be safe
                     // the gap is around ~300ms
-                    send_requests(target, 20);
+                    open_send_window(context, target);
                 }
             }
-            else if (nonpacket_.cmd == NonNasaCommand::CmdC6)
+            else if (nonpacket.cmd == NonNasaCommand::CmdC6)
             {
                 // Some systems send a control message. It seems its possible to request that (SNET does that).
-                if (nonpacket_.src == "c8" && nonpacket_.dst == "d0" && nonpacket_.commandC6.control_status == true)
+                if (nonpacket.src == "c8" && nonpacket.dst == "d0" && nonpacket.commandC6.control_status == true)
                 {
-                    send_requests(target, 20);
+                    open_send_window(context, target);
                 }
             }
         }
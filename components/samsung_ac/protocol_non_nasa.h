@@ -168,7 +168,7 @@ namespace esphome
                 NonNasaCommandRaw commandRaw;
             };
 
-            DecodeResult decode(std::vector<uint8_t> &data);
+            DecodeResult decode(const uint8_t *data, size_t size);
             std::string to_string();
         };
 
@@ -185,18 +185,28 @@ namespace esphome
             std::vector<uint8_t> encode();
             std::string to_string();
 
-            static NonNasaRequest create(std::string dst_address);
+            static NonNasaRequest create(DecoderContext &context, PackedAddress dst_address);
         };
 
-        DecodeResult try_decode_non_nasa_packet(std::vector<uint8_t> data);
-        void process_non_nasa_packet(MessageTarget *target);
+        // After the trigger frame (CmdF8 or CmdC6) the bus is quiet for ~300ms. Requests are sent
+        // from the loop, the first one NON_NASA_SEND_DELAY after the trigger and every further one
+        // NON_NASA_SEND_DELAY after the previous. A request (14 bytes, ~65ms at 2400 baud) is only
+        // started until NON_NASA_WINDOW_CLOSE, so it is done before the gap ends.
+        static const uint32_t NON_NASA_SEND_DELAY = 20;
+        static const uint32_t NON_NASA_WINDOW_CLOSE = 200;
+
+        bool is_non_nasa_packet(const uint8_t *data, size_t size);
+        DecodeResult try_decode_non_nasa_packet(DecoderContext &context, const uint8_t *data, size_t size);
+        void process_non_nasa_packet(DecoderContext &context, MessageTarget *target);
+        // Sends the next queued request while the send window is open, call it from every loop.
+        void send_non_nasa_requests(DecoderContext &context, MessageTarget *target, uint32_t now);
 
         class NonNasaProtocol : public Protocol
         {
         public:
             NonNasaProtocol() = default;
 
-            void publish_request(MessageTarget *target, const std::string &address, ProtocolRequest &request) override;
+            void publish_request(MessageTarget *target, PackedAddress address, ProtocolRequest &request) override;
         };
     } // namespace samsung_ac
 } // namespace esphome
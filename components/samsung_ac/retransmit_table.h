@@ -0,0 +1,238 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include "protocol.h"
+#include "protocol_nasa.h"
+#include "util.h"
+#include "rtt_estimator.h"
+
+namespace esphome
+{
+    namespace samsung_ac
+    {
+        // Sent NASA requests which are not acknowledged yet, keyed by packet number.
+        // The table has a fixed number of entries, so memory use stays bounded even
+        // when a device never answers. An entry whose deadline passes is sent again
+        // with an incremented retry count in its command header until max_retries is
+        // reached, then it is reported as failed and dropped.
+        // The time from sending a request to its Ack feeds the round trip estimate of
+        // the destination, which sets the timeout (doubled with every retry). Requests
+        // which were sent more than once are not measured, the Ack is ambiguous then.
+        // The same measurements pace our sends: the gap between two frames is half the
+        // smoothed round trip time, doubled after every timeout and halved again by
+        // every clean Ack.
+        class RetransmitTable
+        {
+        public:
+            static const size_t ENTRIES = 16;
+            // the retry count has 2 bits in the command header
+            static const uint8_t MAX_RETRY_COUNT = 3;
+            static const uint8_t MAX_PACING_SHIFT = 3;
+            static const uint32_t MAX_PACING_GAP = 2000;
+
+            // timeout until the round trip time of a destination was measured
+            void set_timeout(uint32_t timeout_ms) { rtt_.set_initial_rto(timeout_ms); }
+            uint32_t get_timeout() const { return rtt_.get_initial_rto(); }
+
+            void set_max_retries(uint8_t max_retries) { max_retries_ = max_retries > MAX_RETRY_COUNT ? MAX_RETRY_COUNT : max_retries; }
+            uint8_t get_max_retries() const { return max_retries_; }
+
+            // Remembers an encoded request. Returns false when another unacknowledged
+            // request had to be dropped for it (same packet number or table full), that
+            // one counts as failed.
+            bool add(uint8_t packet_number, PackedAddress destination, const std::vector<uint8_t> &frame, uint32_t now)
+            {
+                bool dropped = false;
+                Entry *slot = find(packet_number);
+                if (slot == nullptr)
+                {
+                    for (size_t i = 0; i < ENTRIES; i++)
+                    {
+                        Entry &entry = entries_[i];
+                        // prefer an unused entry, otherwise the one added longest ago
+                        if (slot == nullptr || (slot->used && (!entry.used || now - entry.added > now - slot->added)))
+                            slot = &entry;
+                    }
+                }
+                if (slot->used)
+                {
+                    failed_++;
+                    dropped = true;
+                }
+
+                slot->used = true;
+                slot->packet_number = packet_number;
+                slot->destination = destination;
+                slot->frame = frame;
+                slot->added = now;
+                slot->retries = 0;
+                slot->on_bus = false;
+                return !dropped;
+            }
+
+            // Called when a frame actually went out on the bus, the timeout starts then.
+            void sent(const uint8_t *data, size_t size, uint32_t now)
+            {
+                if (size < 16 || data[0] != 0x32)
+                    return;
+
+                Entry *entry = find(data[11]);
+                if (entry != nullptr && entry->frame.size() == size)
+                {
+                    entry->sent = now;
+                    entry->on_bus = true;
+                    entry->deadline = now + timeout(*entry);
+                }
+            }
+
+            // A request which could not even be queued is given up right away.
+            void drop(uint8_t packet_number)
+            {
+                Entry *entry = find(packet_number);
+                if (entry == nullptr)
+                    return;
+
+                entry->used = false;
+                entry->frame.clear();
+                entry->frame.shrink_to_fit();
+                failed_++;
+            }
+
+            // Returns true and removes the request when the packet number is pending. Only
+            // an Ack from the destination of the request to us counts, other controllers on
+            // the bus use the same packet numbers.
+            bool acknowledge(uint8_t packet_number, PackedAddress source, PackedAddress destination, uint32_t now)
+            {
+                Entry *entry = find(packet_number);
+                if (entry == nullptr || entry->destination != source || destination != Address::get_my_address().to_packed())
+                    return false;
+
+                if (entry->on_bus && entry->retries == 0)
+                {
+                    rtt_.sample(entry->destination, now - entry->sent);
+                    if (pacing_shift_ > 0)
+                        pacing_shift_--;
+                }
+
+                entry->used = false;
+                entry->frame.clear();
+                entry->frame.shrink_to_fit();
+                acknowledged_++;
+                return true;
+            }
+
+            // Calls resend(frame) for every request whose deadline passed and which has
+            // retries left, failed(destination, packet_number) for the others. Requests
+            // still waiting to be sent have no deadline yet. resend returns false when the
+            // frame could not be queued, that attempt counts as lost then.
+            template <typename Resend, typename Failed>
+            void check_timeouts(uint32_t now, Resend resend, Failed failed)
+            {
+                for (size_t i = 0; i < ENTRIES; i++)
+                {
+                    Entry &entry = entries_[i];
+                    if (!entry.used || !entry.on_bus || (int32_t)(now - entry.deadline) < 0)
+                        continue;
+
+                    // the bus (or the device) is busier than we thought
+                    if (pacing_shift_ < MAX_PACING_SHIFT)
+                        pacing_shift_++;
+
+                    if (entry.retries < max_retries_)
+                    {
+                        entry.retries++;
+                        set_retry_count(entry.frame, entry.retries);
+                        retransmitted_++;
+                        if (resend(entry.frame))
+                            entry.on_bus = false;
+                        else
+                            entry.deadline = now + timeout(entry);
+                        continue;
+                    }
+
+                    entry.used = false;
+                    entry.frame.clear();
+                    entry.frame.shrink_to_fit();
+                    failed_++;
+                    failed(entry.destination, entry.packet_number);
+                }
+            }
+
+            size_t size() const
+            {
+                size_t count = 0;
+                for (size_t i = 0; i < ENTRIES; i++)
+                {
+                    if (entries_[i].used)
+                        count++;
+                }
+                return count;
+            }
+
+            // Minimum time between two of our frames.
+            uint32_t get_pacing_gap() const
+            {
+                const uint32_t gap = (rtt_.overall_srtt() / 2) << pacing_shift_;
+                return gap < MAX_PACING_GAP ? gap : MAX_PACING_GAP;
+            }
+
+            const RttEstimator &get_rtt() const { return rtt_; }
+
+            uint32_t get_acknowledged() const { return acknowledged_; }
+            uint32_t get_retransmitted() const { return retransmitted_; }
+            uint32_t get_failed() const { return failed_; }
+
+            // Sets the retry count in the command header of an encoded NASA frame and updates its checksum.
+            static void set_retry_count(std::vector<uint8_t> &frame, uint8_t retry_count)
+            {
+                if (frame.size() < 16)
+                    return;
+
+                frame[9] = (frame[9] & ~0x18) | ((retry_count & 3) << 3);
+                const uint16_t crc = crc16(frame.data() + 3, frame.size() - 6);
+                frame[frame.size() - 3] = crc >> 8;
+                frame[frame.size() - 2] = crc & 0xFF;
+            }
+
+        protected:
+            struct Entry
+            {
+                std::vector<uint8_t> frame;
+                PackedAddress destination;
+                uint32_t added;
+                uint32_t sent;
+                uint32_t deadline; // valid while on_bus
+                uint8_t packet_number;
+                uint8_t retries;
+                bool on_bus{false}; // sent and deadline are valid
+                bool used{false};
+            };
+
+            uint32_t timeout(const Entry &entry) const
+            {
+                return rtt_.rto(entry.destination) << entry.retries;
+            }
+
+            Entry *find(uint8_t packet_number)
+            {
+                for (size_t i = 0; i < ENTRIES; i++)
+                {
+                    if (entries_[i].used && entries_[i].packet_number == packet_number)
+                        return &entries_[i];
+                }
+                return nullptr;
+            }
+
+            Entry entries_[ENTRIES];
+            RttEstimator rtt_;
+            uint8_t pacing_shift_{0};
+            uint8_t max_retries_{MAX_RETRY_COUNT};
+
+            uint32_t acknowledged_{0};
+            uint32_t retransmitted_{0};
+            uint32_t failed_{0};
+        };
+    } // namespace samsung_ac
+} // namespace esphome
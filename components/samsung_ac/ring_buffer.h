@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+
+namespace esphome
+{
+    namespace samsung_ac
+    {
+        // Fixed-capacity byte ring which stores whole frames. Every frame is kept
+        // contiguous (a frame which does not fit at the end of the buffer starts at
+        // the beginning again) so it can be read in place without copying it.
+        // Layout per frame: 2 byte length (little endian) followed by the data.
+        template <size_t N>
+        class FrameRing
+        {
+        public:
+            bool push(const uint8_t *data, uint16_t size)
+            {
+                const size_t needed = HEADER_SIZE + size;
+                if (size == 0 || needed > N)
+                    return false;
+
+                if (used_ == 0)
+                    head_ = tail_ = 0;
+
+                if (used_ > 0 && tail_ == head_)
+                    return false; // full
+
+                if (tail_ >= head_)
+                {
+                    if (N - tail_ < needed)
+                    {
+                        // no room at the end, continue at the beginning
+                        if (head_ < needed)
+                            return false;
+                        if (N - tail_ >= HEADER_SIZE)
+                            write_size(tail_, SKIP_MARKER);
+                        used_ += N - tail_;
+                        tail_ = 0;
+                    }
+                }
+                else if (head_ - tail_ < needed)
+                {
+                    return false;
+                }
+
+                write_size(tail_, size);
+                std::memcpy(&buffer_[tail_ + HEADER_SIZE], data, size);
+                tail_ += needed;
+                used_ += needed;
+                count_++;
+                return true;
+            }
+
+            // Returns the oldest frame or nullptr when the ring is empty.
+            const uint8_t *front(uint16_t *size) const
+            {
+                if (count_ == 0)
+                    return nullptr;
+
+                *size = read_size(head_);
+                return &buffer_[head_ + HEADER_SIZE];
+            }
+
+            void pop()
+            {
+                if (count_ == 0)
+                    return;
+
+                const size_t consumed = HEADER_SIZE + read_size(head_);
+                head_ += consumed;
+                used_ -= consumed;
+                count_--;
+
+                if (used_ > 0 && (N - head_ < HEADER_SIZE || read_size(head_) == SKIP_MARKER))
+                {
+                    // skip the unused space at the end
+                    used_ -= N - head_;
+                    head_ = 0;
+                }
+            }
+
+            void clear()
+            {
+                head_ = tail_ = used_ = count_ = 0;
+            }
+
+            bool empty() const { return count_ == 0; }
+            size_t count() const { return count_; }
+            size_t bytes_used() const { return used_; }
+            static constexpr size_t capacity() { return N; }
+
+        protected:
+            static const size_t HEADER_SIZE = 2;
+            static const uint16_t SKIP_MARKER = 0xFFFF;
+
+            void write_size(size_t index, uint16_t size)
+            {
+                buffer_[index] = size & 0xFF;
+                buffer_[index + 1] = size >> 8;
+            }
+
+            uint16_t read_size(size_t index) const
+            {
+                return (uint16_t)buffer_[index] | (uint16_t)buffer_[index + 1] << 8;
+            }
+
+            uint8_t buffer_[N];
+            size_t head_{0};
+            size_t tail_{0};
+            size_t used_{0};
+            size_t count_{0};
+        };
+    } // namespace samsung_ac
+} // namespace esphome
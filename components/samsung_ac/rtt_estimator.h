@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include "protocol.h"
+
+namespace esphome
+{
+    namespace samsung_ac
+    {
+        // Smoothed round trip time and its variance per destination, calculated like the
+        // TCP retransmission timeout (RFC 6298). Both are kept in fixed point (srtt * 8,
+        // rttvar * 4) so the updates are shifts and additions only. Destinations without
+        // a measurement yet use the initial timeout.
+        class RttEstimator
+        {
+        public:
+            static const size_t ENTRIES = 16;
+            static const uint32_t MIN_RTO = 200;
+            static const uint32_t MAX_RTO = 10000;
+
+            void set_initial_rto(uint32_t ms) { initial_rto_ = ms; }
+            uint32_t get_initial_rto() const { return initial_rto_; }
+
+            void sample(PackedAddress destination, uint32_t rtt)
+            {
+                update(find_or_add(destination), rtt);
+                update(overall_, rtt);
+            }
+
+            // Retransmission timeout for the destination.
+            uint32_t rto(PackedAddress destination) const
+            {
+                const Estimate *estimate = find(destination);
+                if (estimate == nullptr)
+                    return initial_rto_;
+
+                uint32_t rto = (estimate->srtt8 >> 3) + (estimate->rttvar4 > 0 ? estimate->rttvar4 : 1);
+                if (rto < MIN_RTO)
+                    rto = MIN_RTO;
+                if (rto > MAX_RTO)
+                    rto = MAX_RTO;
+                return rto;
+            }
+
+            // Smoothed round trip time of the destination, 0 when never measured.
+            uint32_t srtt(PackedAddress destination) const
+            {
+                const Estimate *estimate = find(destination);
+                return estimate != nullptr ? estimate->srtt8 >> 3 : 0;
+            }
+
+            // Smoothed round trip time over all destinations, 0 when never measured.
+            uint32_t overall_srtt() const { return overall_.valid ? overall_.srtt8 >> 3 : 0; }
+
+        protected:
+            struct Estimate
+            {
+                PackedAddress destination;
+                uint32_t srtt8{0};
+                uint32_t rttvar4{0};
+                uint32_t samples{0};
+                bool valid{false};
+            };
+
+            static void update(Estimate &estimate, uint32_t rtt)
+            {
+                if (!estimate.valid)
+                {
+                    estimate.valid = true;
+                    estimate.srtt8 = rtt << 3;
+                    estimate.rttvar4 = rtt << 1; // rttvar = rtt / 2
+                }
+                else
+                {
+                    // srtt += (rtt - srtt) / 8, rttvar += (|rtt - srtt| - rttvar) / 4
+                    const int32_t delta = (int32_t)rtt - (int32_t)(estimate.srtt8 >> 3);
+                    estimate.srtt8 += delta;
+                    estimate.rttvar4 += (delta < 0 ? -delta : delta) - (int32_t)(estimate.rttvar4 >> 2);
+                }
+                estimate.samples++;
+            }
+
+            const Estimate *find(PackedAddress destination) const
+            {
+                for (size_t i = 0; i < ENTRIES; i++)
+                {
+                    if (entries_[i].valid && entries_[i].destination == destination)
+                        return &entries_[i];
+                }
+                return nullptr;
+            }
+
+            Estimate &find_or_add(PackedAddress destination)
+            {
+                Estimate *slot = nullptr;
+                for (size_t i = 0; i < ENTRIES; i++)
+                {
+                    Estimate &entry = entries_[i];
+                    if (entry.valid && entry.destination == destination)
+                        return entry;
+                    // reuse the entry with the fewest samples when all are taken
+                    if (slot == nullptr || (slot->valid && (!entry.valid || entry.samples < slot->samples)))
+                        slot = &entry;
+                }
+
+                *slot = Estimate();
+                slot->destination = destination;
+                return *slot;
+            }
+
+            Estimate entries_[ENTRIES];
+            Estimate overall_;
+            uint32_t initial_rto_{1000};
+        };
+    } // namespace samsung_ac
+} // namespace esphome
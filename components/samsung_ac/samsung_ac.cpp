@@ -1,8 +1,10 @@
 #include "esphome/core/log.h"
 #include "samsung_ac.h"
+#include "samsung_ac_group.h"
 #include "debug_mqtt.h"
 #include "util.h"
 #include <vector>
+#include <algorithm>
 
 namespace esphome
 {
@@ -11,6 +13,45 @@ namespace esphome
     void Samsung_AC::setup()
     {
       ESP_LOGW(TAG, "setup");
+
+      // devices and their entities are fixed after setup, so the subscriptions are indexed once
+      subscriptions_.clear();
+      for (const auto &pair : devices_)
+        pair.second->add_subscriptions(subscriptions_);
+      std::stable_sort(subscriptions_.begin(), subscriptions_.end(), [](const Samsung_AC_Subscription &a, const Samsung_AC_Subscription &b)
+                       { return a.key < b.key; });
+      subscriptions_.shrink_to_fit();
+
+      // devices_ is ordered, so are the addresses
+      decoder_context_.configured_addresses.clear();
+      for (const auto &pair : devices_)
+        decoder_context_.configured_addresses.push_back(pair.first);
+
+      for (const auto &pair : devices_)
+      {
+        if (pair.second->polls.size() > 0 && !is_nasa_address(pair.first))
+        {
+          ESP_LOGW(TAG, "Polling is only supported by NASA devices, ignoring it for %s", pair.second->address.c_str());
+          continue;
+        }
+        for (const auto &poll : pair.second->polls)
+          decoder_context_.polls.add(pair.first, poll.message_number, poll.interval);
+      }
+
+      for (auto *group : groups_)
+        group->setup(devices_);
+
+#ifdef USE_ESP32
+      if (rx_task_enabled_)
+      {
+        const BaseType_t core = rx_task_core_ < 0 ? tskNO_AFFINITY : rx_task_core_;
+        if (xTaskCreatePinnedToCore(rx_task, "samsung_ac_rx", 4096, this, 5, &rx_task_handle_, core) != pdPASS)
+        {
+          ESP_LOGE(TAG, "Could not start the rx task, reading in the main loop");
+          rx_task_handle_ = nullptr;
+        }
+      }
+#endif
     }
 
     void Samsung_AC::update()
@@ -36,9 +77,10 @@ namespace esphome
       std::string knownIndoor = "";
       std::string knownOutdoor = "";
       std::string knownOther = "";
-      for (auto const &address : addresses_)
+      for (auto const packed : addresses_)
       {
-        switch (get_address_type(address))
+        const std::string address = address_to_string(packed);
+        switch (get_address_type(packed))
         {
         case AddressType::Outdoor:
           knownOutdoor += knownOutdoor.length() > 0 ? ", " + address : address;
@@ -56,28 +98,195 @@ namespace esphome
       ESP_LOGCONFIG(TAG, "  Indoor:  %s", (knownIndoor.length() == 0 ? "-" : knownIndoor.c_str()));
       if (knownOther.length() > 0)
         ESP_LOGCONFIG(TAG, "  Other:   %s", knownOther.c_str());
+
+      if (loop_budget_exhausted_ > 0)
+        ESP_LOGCONFIG(TAG, "Loop time budget exhausted %u times", loop_budget_exhausted_);
+
+      if (decoder_context_.duplicates.get_dropped() > 0)
+        ESP_LOGCONFIG(TAG, "Skipped %u duplicate frames", decoder_context_.duplicates.get_dropped());
+
+      if (decoder_context_.filtered_frames > 0)
+        ESP_LOGCONFIG(TAG, "Filtered %u frames of unconfigured devices", decoder_context_.filtered_frames);
+
+      if (tx_scheduler_.get_deferred() > 0 || tx_scheduler_.get_collided() > 0)
+        ESP_LOGCONFIG(TAG, "Sent %u frames, %u deferred because of bus traffic, %u collided", tx_scheduler_.get_sent(), tx_scheduler_.get_deferred(), tx_scheduler_.get_collided());
+
+      const uint32_t now = millis();
+      for (size_t i = 0; i < TxQueue::CLASSES; i++)
+      {
+        const TxPriority priority = (TxPriority)i;
+        if (tx_queue_depth_sensors_[i] != nullptr)
+          tx_queue_depth_sensors_[i]->publish_state(send_queue_.depth(priority));
+        const uint32_t wait = send_queue_.take_max_wait(priority, now);
+        if (tx_wait_time_sensors_[i] != nullptr)
+          tx_wait_time_sensors_[i]->publish_state(wait);
+        if (send_queue_.get_dropped(priority) > 0)
+          ESP_LOGCONFIG(TAG, "Send queue %s dropped %u frames", tx_priority_to_string(priority), send_queue_.get_dropped(priority));
+      }
+
+      if (echo_.get_mismatched() > 0 || echo_.get_missing() > 0)
+        ESP_LOGCONFIG(TAG, "Echo check: %u frames matched, %u collided, %u without echo", echo_.get_matched(), echo_.get_mismatched(), echo_.get_missing());
+
+      const RetransmitTable &requests = decoder_context_.requests;
+      if (requests.get_retransmitted() > 0 || requests.get_failed() > 0)
+        ESP_LOGCONFIG(TAG, "Requests: %u acknowledged, %u sent again, %u failed", requests.get_acknowledged(), requests.get_retransmitted(), requests.get_failed());
+      if (requests.get_rtt().overall_srtt() > 0)
+        ESP_LOGCONFIG(TAG, "Round trip time %u ms, sending at most every %u ms", requests.get_rtt().overall_srtt(), requests.get_pacing_gap());
+
+#ifdef USE_ESP32
+      if (rx_queue_.get_dropped() > 0)
+        ESP_LOGCONFIG(TAG, "Rx task dropped %u of %u frames", rx_queue_.get_dropped(), rx_queue_.get_dropped() + rx_queue_.get_pushed());
+#endif
     }
 
     void Samsung_AC::register_device(Samsung_AC_Device *device)
     {
-      if (find_device(device->address) != nullptr)
+      if (find_device(device->packed_address) != nullptr)
       {
         ESP_LOGW(TAG, "There is already and device for address %s registered.", device->address.c_str());
         return;
       }
 
-      devices_.insert({device->address, device});
+      devices_.insert({device->packed_address, device});
+    }
+
+    std::vector<Samsung_AC_Subscription>::const_iterator Samsung_AC::find_subscription(uint64_t key) const
+    {
+      return std::lower_bound(subscriptions_.begin(), subscriptions_.end(), key, [](const Samsung_AC_Subscription &subscription, uint64_t key)
+                              { return subscription.key < key; });
+    }
+
+    void Samsung_AC::dispatch_message(PackedAddress address, uint16_t message_number, long value)
+    {
+      const uint64_t key = Samsung_AC_Subscription::make_key(address, message_number);
+      for (auto it = find_subscription(key); it != subscriptions_.end() && it->key == key; ++it)
+        it->device->publish_subscription(*it, message_number, value);
+    }
+
+    bool Samsung_AC::is_subscribed(PackedAddress address, uint16_t message_number)
+    {
+      const uint64_t key = Samsung_AC_Subscription::make_key(address, message_number);
+      auto it = find_subscription(key);
+      return it != subscriptions_.end() && it->key == key;
     }
 
     void Samsung_AC::dump_config()
     {
     }
 
-    void Samsung_AC::publish_data(std::vector<uint8_t> &data)
+    bool Samsung_AC::publish_data(std::vector<uint8_t> &data)
+    {
+      bool collided;
+      return write_frame(data.data(), data.size(), &collided);
+    }
+
+    // Returns false when the frame collided and should be sent again. A frame is given
+    // up after MAX_COLLISIONS_IN_ROW collisions in a row.
+    bool Samsung_AC::write_frame(const uint8_t *data, size_t size, bool *collided)
     {
-      ESP_LOGW(TAG, "write %s", bytes_to_hex(data).c_str());
-      this->write_array(data);
+      bool rx_task_running = false;
+#ifdef USE_ESP32
+      rx_task_running = rx_task_handle_ != nullptr;
+#endif
+
+      ESP_LOGW(TAG, "write %s", bytes_to_hex(data, size).c_str());
+      if (echo_check_)
+        echo_.arm(data, size);
+      // the rx task consumes the bytes itself, it counts them for us
+      const uint32_t received_before = rx_task_running ? rx_bytes_.load() : available();
+      this->write_array(data, size);
       this->flush();
+
+      if (!echo_check_)
+      {
+        // flush() returns once the frame is out. Many adapters echo what we send, so
+        // only more bytes than we sent mean another sender was talking at the same time.
+        const uint32_t received = (rx_task_running ? rx_bytes_.load() : available()) - received_before;
+        *collided = received > size;
+      }
+      else
+      {
+        // the last bytes of the echo can still be on their way through the UART driver
+        const uint32_t timeout = ECHO_TIMEOUT_CHARS * 10000 / parent_->get_baud_rate() + 1;
+        const uint32_t waiting = millis();
+        while (echo_.pending() && millis() - waiting < timeout)
+        {
+          uint8_t c;
+          if (!rx_task_running && available() && read_byte(&c))
+          {
+            // from the first differing byte on it is somebody else's data
+            if (!echo_.feed(c) && framer_.push(c))
+              process_frames();
+            continue;
+          }
+          delay(1);
+        }
+
+        const EchoChecker::Result result = echo_.take();
+        *collided = result == EchoChecker::Result::Mismatch;
+        if (result == EchoChecker::Result::Missing)
+          ESP_LOGW(TAG, "No echo of the sent frame, does the adapter suppress it?");
+        else if (*collided)
+          ESP_LOGW(TAG, "Echo differs from the sent frame");
+      }
+
+      if (!*collided)
+      {
+        collisions_in_row_ = 0;
+        return true;
+      }
+
+      if (++collisions_in_row_ < MAX_COLLISIONS_IN_ROW)
+        return false;
+
+      ESP_LOGE(TAG, "Collided %d times in a row, giving up on %s", MAX_COLLISIONS_IN_ROW, bytes_to_hex(data, size).c_str());
+      collisions_in_row_ = 0;
+      return true;
+    }
+
+    bool Samsung_AC::queue_data(std::vector<uint8_t> &data, TxPriority priority)
+    {
+      if (send_queue_.push(priority, data.data(), data.size(), millis()))
+        return true;
+
+      ESP_LOGE(TAG, "Send queue full, dropping %s", bytes_to_hex(data).c_str());
+      return false;
+    }
+
+    void Samsung_AC::send_queued()
+    {
+      uint16_t size;
+      TxPriority priority;
+      const uint8_t *senddata = send_queue_.front(millis(), &size, &priority);
+      if (senddata == nullptr)
+        return;
+
+      bool rx_task_running = false;
+#ifdef USE_ESP32
+      rx_task_running = rx_task_handle_ != nullptr;
+#endif
+
+      // never start in the middle of a frame someone else is sending (the rx task owns the framer)
+      if (!rx_task_running && !framer_.empty())
+        return;
+
+      // read before millis(), the rx task could update it in between
+      const uint32_t last_rx = last_transmission_;
+      tx_scheduler_.set_min_gap(decoder_context_.requests.get_pacing_gap());
+      if (!tx_scheduler_.may_send(millis(), last_rx))
+        return;
+
+      bool collided;
+      if (write_frame(senddata, size, &collided))
+      {
+        // a frame to send again stays at the front of its queue
+        decoder_context_.requests.sent(senddata, size, millis());
+        send_queue_.pop(priority, millis());
+      }
+
+      if (collided)
+        ESP_LOGW(TAG, "Collision while sending, backing off");
+      tx_scheduler_.sent(collided, millis());
     }
 
     void Samsung_AC::loop()
@@ -86,43 +295,165 @@ namespace esphome
         return;
 
       const uint32_t now = millis();
-      if (data_.size() > 0 && (now - last_transmission_ >= 500))
+      send_pending_nasa_requests(decoder_context_, this, now);
+      check_nasa_timeouts(decoder_context_, this, now);
+      send_non_nasa_requests(decoder_context_, this, now);
+      poll_nasa_messages(decoder_context_, this, now);
+
+#ifdef USE_ESP32
+      if (rx_task_handle_ != nullptr)
+      {
+        process_rx_queue();
+        return;
+      }
+#endif
+
+      if (!framer_.empty() && (now - last_transmission_ >= 500))
       {
         ESP_LOGW(TAG, "Last transmission too long ago. Reset RX index.");
-        data_.clear();
+        framer_.clear();
       }
 
       // If there is no data we use the time to send
       if (!available())
       {
-        if (send_queue_.size() > 0)
-        {
-          auto senddata = send_queue_.front();
-          publish_data(senddata);
-          send_queue_.pop();
-        }
-
+        send_queued();
         return; // nothing in uart-input-buffer, end here
       }
 
-      last_transmission_ = now;
+      // sending above may have blocked for a while, the budget is for reading only
+      const uint32_t started = millis();
+      last_transmission_ = started;
       while (available())
       {
         uint8_t c;
-        if (!read_byte(&c))
+        if (read_byte(&c) && framer_.push(c))
+          process_frames();
+
+        if (available() && millis() - started >= max_loop_time_)
+        {
+          // leave the remaining bytes for the next loop so other components are not starved
+          loop_budget_exhausted_++;
+          break;
+        }
+      }
+    }
+
+    void Samsung_AC::process_frames()
+    {
+      // a resync can leave more than one complete frame in the framer
+      last_frame_received_us_ = micros();
+      do
+      {
+        process_data(decoder_context_, framer_.data(), framer_.size(), this, framer_.crc_checked());
+      } while (framer_.next());
+    }
+
+#ifdef USE_ESP32
+    // Owns framer_ while it runs, the main loop only touches rx_queue_.
+    void Samsung_AC::rx_task(void *arg)
+    {
+      Samsung_AC *self = static_cast<Samsung_AC *>(arg);
+      uint8_t buffer[128];
+
+#ifdef USE_ESP_IDF
+      // Blocks in the UART driver until bytes arrive, so the end of every frame is
+      // seen (and timestamped) right when it is received instead of on the next poll.
+      const uart_port_t port = (uart_port_t) static_cast<uart::IDFUARTComponent *>(self->parent_)->get_hw_serial_number();
+      while (true)
+      {
+        int received = uart_read_bytes(port, buffer, 1, pdMS_TO_TICKS(500));
+        if (received <= 0)
+        {
+          // nothing for 500ms, a partial frame will never complete
+          self->framer_.clear();
           continue;
-        if (data_.size() == 0 && c != 0x32)
-          continue; // skip until start-byte found
+        }
 
-        data_.push_back(c);
+        size_t buffered = 0;
+        uart_get_buffered_data_len(port, &buffered);
+        if (buffered > 0)
+        {
+          const int more = uart_read_bytes(port, buffer + 1, std::min(buffered, sizeof(buffer) - 1), 0);
+          if (more > 0)
+            received += more;
+        }
 
-        if (process_data(data_, this) == DataResult::Clear)
+        self->rx_task_receive(buffer, received);
+      }
+#else
+      while (true)
+      {
+        const size_t available = self->available();
+        if (available == 0)
         {
-          data_.clear();
-          break; // wait for next loop
+          if (!self->framer_.empty() && millis() - self->last_transmission_ >= 500)
+            self->framer_.clear();
+          vTaskDelay(1);
+          continue;
+        }
+
+        const size_t size = std::min(available, sizeof(buffer));
+        if (self->read_array(buffer, size))
+          self->rx_task_receive(buffer, size);
+      }
+#endif
+    }
+
+    void Samsung_AC::rx_task_receive(const uint8_t *data, size_t size)
+    {
+      RxFrameInfo info;
+      info.received_us = micros();
+      last_transmission_ = millis();
+      rx_bytes_ += size;
+
+      for (size_t i = 0; i < size; i++)
+      {
+        // our own bytes coming back
+        if (echo_.feed(data[i]))
+          continue;
+        if (!framer_.push(data[i]))
+          continue;
+
+        do
+        {
+          // frames are of no use before processing starts
+          if (!data_processing_init)
+          {
+            info.crc_checked = framer_.crc_checked();
+            rx_queue_.push(framer_.data(), framer_.size(), info);
+          }
+        } while (framer_.next());
+      }
+    }
+
+    void Samsung_AC::process_rx_queue()
+    {
+      uint16_t size;
+      RxFrameInfo info;
+      const uint8_t *frame = rx_queue_.front(&size, &info);
+      if (frame == nullptr)
+      {
+        send_queued();
+        return;
+      }
+
+      const uint32_t started = millis();
+      while (frame != nullptr)
+      {
+        last_frame_received_us_ = info.received_us;
+        process_data(decoder_context_, frame, size, this, info.crc_checked);
+        rx_queue_.pop();
+        frame = rx_queue_.front(&size, &info);
+
+        if (frame != nullptr && millis() - started >= max_loop_time_)
+        {
+          loop_budget_exhausted_++;
+          break;
         }
       }
     }
+#endif
 
     float Samsung_AC::get_setup_priority() const { return setup_priority::DATA; }
   } // namespace samsung_ac
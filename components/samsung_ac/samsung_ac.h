@@ -1,13 +1,29 @@
 #pragma once
 
 #include <set>
+#include <atomic>
 #include <map>
 #include <optional>
-#include <queue>
 #include "esphome/core/component.h"
 #include "esphome/components/uart/uart.h"
+#include "esphome/components/sensor/sensor.h"
 #include "samsung_ac_device.h"
 #include "protocol.h"
+#include "decoder_context.h"
+#include "ring_buffer.h"
+#include "spsc_ring.h"
+#include "tx_scheduler.h"
+#include "tx_queue.h"
+#include "echo_checker.h"
+
+#ifdef USE_ESP32
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#endif
+#ifdef USE_ESP_IDF
+#include <driver/uart.h>
+#include "esphome/components/uart/uart_component_esp_idf.h"
+#endif
 
 namespace esphome
 {
@@ -15,6 +31,14 @@ namespace esphome
   {
     class NasaProtocol;
     class Samsung_AC_Device;
+    class Samsung_AC_Group;
+
+    // Handed over with every frame the rx task received.
+    struct RxFrameInfo
+    {
+      uint32_t received_us; // micros() when the end of the frame was read from the driver
+      bool crc_checked;
+    };
 
     class Samsung_AC : public PollingComponent,
                        public uart::UARTDevice,
@@ -39,91 +63,149 @@ namespace esphome
 
       void set_debug_log_messages(bool value)
       {
-        debug_log_packets = value;
+        decoder_context_.debug_log_packets = value;
       }
 
       void set_debug_log_messages_raw(bool value)
       {
-        debug_log_raw_bytes = value;
+        decoder_context_.debug_log_raw_bytes = value;
       }
 
-      void register_device(Samsung_AC_Device *device);
+      void set_max_loop_time(uint32_t value)
+      {
+        max_loop_time_ = value;
+      }
 
-      void /*MessageTarget::*/ register_address(const std::string address) override
+      void set_skip_duplicate_frames(bool value)
       {
-        addresses_.insert(address);
+        decoder_context_.duplicates.set_enabled(value);
       }
 
-      uint32_t /*MessageTarget::*/ get_miliseconds()
+      void set_duplicate_frame_window(uint32_t value)
       {
-        return millis();
+        decoder_context_.duplicates.set_window(value);
       }
 
-      void /*MessageTarget::*/ publish_data(std::vector<uint8_t> &data);
+      void set_filter_unconfigured_devices(bool value)
+      {
+        decoder_context_.filter_unconfigured = value;
+      }
 
+      void set_discovery_sample_rate(uint16_t value)
+      {
+        decoder_context_.discovery_sample_rate = value;
+      }
 
+      // ESP32 only: read and frame the UART data in an own FreeRTOS task, which can be
+      // pinned to a core (-1 lets FreeRTOS choose). The main loop only decodes.
+      void set_rx_task(bool enabled, int core)
+      {
+        rx_task_enabled_ = enabled;
+        rx_task_core_ = core;
+      }
 
-      void /*MessageTarget::*/ getValueForCustomClimate(const std::string source, uint16_t messageNumber, long value) {
-        Samsung_AC_Device *dev = find_device(source);
-        if (dev != nullptr) dev->getValueForCustomClimate(messageNumber, value);
+      // Queued frames are only sent after the bus was quiet for idle_gap plus a random backoff of up to max_backoff.
+      void set_tx_idle_gap(uint32_t value)
+      {
+        tx_scheduler_.set_idle_gap(value);
+      }
 
+      void set_tx_max_backoff(uint32_t value)
+      {
+        tx_scheduler_.set_max_backoff(value);
       }
 
+      // Control changes of a device are collected this long and sent as one NASA packet.
+      void set_request_settle_window(uint32_t value)
+      {
+        decoder_context_.request_settle_window = value;
+      }
 
+      // NASA requests which are not acknowledged within the timeout are sent again up to retries times.
+      void set_request_timeout(uint32_t value)
+      {
+        decoder_context_.requests.set_timeout(value);
+      }
 
-      void /*MessageTarget::*/ set_mode(const std::string address, Mode mode) override
+      void set_request_retries(uint8_t value)
       {
-        Samsung_AC_Device *dev = find_device(address);
-        if (dev != nullptr)
-          dev->update_mode(mode);
+        decoder_context_.requests.set_max_retries(value);
       }
 
-      optional<std::set<uint16_t>> /*MessageTarget::*/ get_custom_sensors(const std::string address) override
+      // A frame of a lower priority which waited this long is sent before higher ones.
+      void set_tx_starvation_limit(uint32_t value)
       {
-        Samsung_AC_Device *dev = find_device(address);
-        if (dev != nullptr)
-          return optional<std::set<uint16_t>>(dev->get_custom_sensors());
-        return optional<std::set<uint16_t>>();
+        send_queue_.set_starvation_limit(value);
       }
-      
-      void /*MessageTarget::*/ set_custom_sensor(const std::string address, uint16_t message_number, float value) override
+
+      // For adapters which echo the sent bytes: compare the echo with the frame, a
+      // difference is a collision. The echo is never decoded.
+      void set_tx_echo_check(bool value)
       {
-        Samsung_AC_Device *dev = find_device(address);
-        if (dev != nullptr)
-          dev->update_custom_sensor(message_number, value);
+        echo_check_ = value;
       }
 
-      optional<std::set<uint16_t>> /*MessageTarget::*/ get_custom_switches(const std::string address) override
+      // Published on every update: frames waiting and the longest wait since the last update.
+      void set_tx_queue_sensors(int priority, sensor::Sensor *depth, sensor::Sensor *wait_time)
       {
-        Samsung_AC_Device *dev = find_device(address);
-        if (dev != nullptr)
-          return optional<std::set<uint16_t>>(dev->get_custom_switches());
-        return optional<std::set<uint16_t>>();
+        tx_queue_depth_sensors_[priority] = depth;
+        tx_wait_time_sensors_[priority] = wait_time;
+      }
+
+      const TransmitScheduler &get_tx_scheduler() const
+      {
+        return tx_scheduler_;
       }
-      
-      void /*MessageTarget::*/ set_custom_switch(const std::string address, uint16_t message_number, bool value) override
+
+      uint32_t get_loop_budget_exhausted() const
       {
-        Samsung_AC_Device *dev = find_device(address);
-        if (dev != nullptr)
-          dev->update_custom_switch(message_number, value);
+        return loop_budget_exhausted_;
       }
 
-      optional<std::set<uint16_t>> /*MessageTarget::*/ get_custom_numbers(const std::string address) override
+      void register_device(Samsung_AC_Device *device);
+
+      void register_group(Samsung_AC_Group *group)
       {
-        Samsung_AC_Device *dev = find_device(address);
-        if (dev != nullptr)
-          return optional<std::set<uint16_t>>(dev->get_custom_numbers());
-        return optional<std::set<uint16_t>>();
+        groups_.push_back(group);
+      }
+
+      void /*MessageTarget::*/ register_address(PackedAddress address) override
+      {
+        addresses_.insert(address);
+      }
+
+      uint32_t /*MessageTarget::*/ get_miliseconds()
+      {
+        return millis();
       }
-      
-      void /*MessageTarget::*/ set_custom_number(const std::string address, uint16_t message_number, float value) override
+
+      uint32_t /*MessageTarget::*/ get_frame_received_miliseconds() override
+      {
+        // frames can wait a while in the rx queue before they are processed
+        return millis() - (micros() - last_frame_received_us_) / 1000;
+      }
+
+      DecoderContext & /*MessageTarget::*/ get_decoder_context() override
+      {
+        return decoder_context_;
+      }
+
+      bool /*MessageTarget::*/ publish_data(std::vector<uint8_t> &data) override;
+
+      bool /*MessageTarget::*/ queue_data(std::vector<uint8_t> &data, TxPriority priority) override;
+
+      void /*MessageTarget::*/ set_mode(PackedAddress address, Mode mode) override
       {
         Samsung_AC_Device *dev = find_device(address);
         if (dev != nullptr)
-          dev->update_custom_number(message_number, value);
+          dev->update_mode(mode);
       }
-      
-      Samsung_AC_Device *find_device(const std::string address)
+
+      void /*MessageTarget::*/ dispatch_message(PackedAddress address, uint16_t message_number, long value) override;
+
+      bool /*MessageTarget::*/ is_subscribed(PackedAddress address, uint16_t message_number) override;
+
+      Samsung_AC_Device *find_device(PackedAddress address)
       {
         auto it = devices_.find(address);
         if (it != devices_.end())
@@ -135,20 +217,60 @@ namespace esphome
 
     protected:
 
-      std::map<std::string, Samsung_AC_Device *> devices_;
-      std::set<std::string> addresses_;
+      std::map<PackedAddress, Samsung_AC_Device *> devices_;
+      std::vector<Samsung_AC_Group *> groups_;
+      std::set<PackedAddress> addresses_;
+      // built in setup(), sorted by key
+      std::vector<Samsung_AC_Subscription> subscriptions_;
+      std::vector<Samsung_AC_Subscription>::const_iterator find_subscription(uint64_t key) const;
+
+      TxQueue send_queue_;
+      sensor::Sensor *tx_queue_depth_sensors_[TxQueue::CLASSES]{};
+      sensor::Sensor *tx_wait_time_sensors_[TxQueue::CLASSES]{};
+      TransmitScheduler tx_scheduler_;
+      // a frame which collided this often in a row is given up
+      static const uint8_t MAX_COLLISIONS_IN_ROW = 3;
+      // how long to wait for the echo after flush(), in character times
+      static const uint32_t ECHO_TIMEOUT_CHARS = 20;
+      EchoChecker echo_;
+      bool echo_check_{false};
+      uint8_t collisions_in_row_{0};
+      Framer framer_;
+      DecoderContext decoder_context_;
+      // millis() of the last received byte, written by the rx task too
+      std::atomic<uint32_t> last_transmission_{0};
+      // bytes received by the rx task, to tell collisions from our own echo
+      std::atomic<uint32_t> rx_bytes_{0};
+      // micros() when the end of the last processed frame was received
+      uint32_t last_frame_received_us_{0};
+      uint32_t loop_budget_exhausted_{0};
+
+      void send_queued();
+      bool write_frame(const uint8_t *data, size_t size, bool *collided);
+      // processes the frames which are complete in framer_
+      void process_frames();
+
+#ifdef USE_ESP32
+      static void rx_task(void *arg);
+      void rx_task_receive(const uint8_t *data, size_t size);
+      void process_rx_queue();
 
-      std::queue<std::vector<uint8_t>> send_queue_;
-      std::vector<uint8_t> data_;
-      uint32_t last_transmission_{0};
+      TaskHandle_t rx_task_handle_{nullptr};
+      // complete frames from the rx task
+      SpscFrameRing<4096, RxFrameInfo> rx_queue_;
+#endif
+      bool rx_task_enabled_{false};
+      int rx_task_core_{-1};
 
-      bool data_processing_init = true;
+      // read by the rx task too
+      std::atomic<bool> data_processing_init{true};
 
       // settings from yaml
       std::string debug_mqtt_host = "";
       uint16_t debug_mqtt_port = 1883;
       std::string debug_mqtt_username = "";
       std::string debug_mqtt_password = "";
+      uint32_t max_loop_time_{5};
     };
 
   } // namespace samsung_ac
@@ -40,7 +40,7 @@ namespace esphome
         fan.insert(climate::ClimateFanMode::CLIMATE_FAN_AUTO);
       }
 
-      if (is_nasa_address(device->address))
+      if (is_nasa_address(device->packed_address))
       {
         // fan.insert(climate::ClimateFanMode::CLIMATE_FAN_DIFFUSE);
       }
@@ -155,28 +155,87 @@ namespace esphome
       request.alt_mode = mode->value;
     }
 
-    void Samsung_AC_Device::getValueForCustomClimate(uint16_t address, long value) {
-      for (auto& cc: custom_climates) {
-        if (address == cc->modeAddr && cc->modeAddr) {
-          cc->lastReadMode = value;
-          cc->publishMode();
-        } else if (address == cc->enable) {
-          cc->lastEnabled = value;
-          cc->publishMode();
-        } else if (address == cc->presAddr &&  cc->presAddr) {
-          cc->lastReadPres = value;
-          cc->publishMode();
-        } else if (address == cc->set) {
-          float tempe = (float)value / 10.0;
-          cc->target_temperature = tempe;
-          cc->publish_state();
-          ESP_LOGV(TAG, "CC changed setpoint, read %f for addr %x", tempe, address);
-        } else if (address == cc->status) {
-          float tempe = (float)value / 10.0;
-          cc->current_temperature = tempe;
-          cc->publish_state();
-          ESP_LOGV(TAG, "CC changed status, read %f for addr %x", tempe, address);
-        }
+    void Samsung_AC_Device::add_subscriptions(std::vector<Samsung_AC_Subscription> &subscriptions)
+    {
+      auto add = [&](uint16_t message_number, SubscriptionKind kind, size_t index)
+      {
+        Samsung_AC_Subscription subscription;
+        subscription.key = Samsung_AC_Subscription::make_key(packed_address, message_number);
+        subscription.device = this;
+        subscription.kind = kind;
+        subscription.index = (uint16_t)index;
+        subscriptions.push_back(subscription);
+      };
+
+      for (size_t i = 0; i < custom_sensors.size(); i++)
+        add(custom_sensors[i].message_number, SubscriptionKind::Sensor, i);
+      for (size_t i = 0; i < custom_switches.size(); i++)
+        add(custom_switches[i].message_number, SubscriptionKind::Switch, i);
+      for (size_t i = 0; i < custom_numbers.size(); i++)
+        add(custom_numbers[i].message_number, SubscriptionKind::Number, i);
+
+      for (size_t i = 0; i < custom_climates.size(); i++)
+      {
+        auto cc = custom_climates[i];
+        std::set<uint16_t> messages{cc->enable, cc->set, cc->status};
+        if (cc->modeAddr)
+          messages.insert(cc->modeAddr);
+        if (cc->presAddr)
+          messages.insert(cc->presAddr);
+        for (auto message_number : messages)
+          add(message_number, SubscriptionKind::Climate, i);
+      }
+    }
+
+    void Samsung_AC_Device::publish_subscription(const Samsung_AC_Subscription &subscription, uint16_t message_number, long value)
+    {
+      switch (subscription.kind)
+      {
+      case SubscriptionKind::Sensor:
+      {
+        // Special handling for room temperature sensor (applies offset)
+        const float offset = message_number == 0x4203 /* VAR_in_temp_room_f */ ? room_temperature_offset : 0;
+        custom_sensors[subscription.index].sensor->publish_state((float)value + offset);
+        break;
+      }
+      case SubscriptionKind::Switch:
+        custom_switches[subscription.index].switch_device->publish_state(value != 0);
+        // Special handling for power switch (tracks state)
+        if (message_number == 0x4000) // ENUM_in_operation_power
+          _cur_power = value != 0;
+        break;
+      case SubscriptionKind::Number:
+      {
+        auto &custom_number = custom_numbers[subscription.index];
+        custom_number.number_device->publish_state((float)value * custom_number.multiply);
+        break;
+      }
+      case SubscriptionKind::Climate:
+        update_custom_climate(custom_climates[subscription.index], message_number, value);
+        break;
+      }
+    }
+
+    void Samsung_AC_Device::update_custom_climate(Samsung_AC_CustClim *cc, uint16_t address, long value) {
+      if (address == cc->modeAddr && cc->modeAddr) {
+        cc->lastReadMode = value;
+        cc->publishMode();
+      } else if (address == cc->enable) {
+        cc->lastEnabled = value;
+        cc->publishMode();
+      } else if (address == cc->presAddr &&  cc->presAddr) {
+        cc->lastReadPres = value;
+        cc->publishMode();
+      } else if (address == cc->set) {
+        float tempe = (float)value / 10.0;
+        cc->target_temperature = tempe;
+        cc->publish_state();
+        ESP_LOGV(TAG, "CC changed setpoint, read %f for addr %x", tempe, address);
+      } else if (address == cc->status) {
+        float tempe = (float)value / 10.0;
+        cc->current_temperature = tempe;
+        cc->publish_state();
+        ESP_LOGV(TAG, "CC changed status, read %f for addr %x", tempe, address);
       }
     }
 
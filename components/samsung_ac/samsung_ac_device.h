@@ -90,25 +90,61 @@ namespace esphome
       float multiply;
     };
 
+    // A message which is read from the device every interval milliseconds.
+    struct Samsung_AC_Poll
+    {
+      uint16_t message_number;
+      uint32_t interval;
+    };
+
+    enum class SubscriptionKind : uint8_t
+    {
+      Sensor,
+      Switch,
+      Number,
+      Climate
+    };
+
+    // Binds a message of a device to one of its entities. Samsung_AC keeps all
+    // subscriptions sorted by key, so a received message is dispatched with a
+    // single lookup.
+    struct Samsung_AC_Subscription
+    {
+      uint64_t key;
+      Samsung_AC_Device *device;
+      SubscriptionKind kind;
+      uint16_t index; // position within the device's list of entities of that kind
+
+      static uint64_t make_key(PackedAddress address, uint16_t message_number)
+      {
+        return (uint64_t)address << 16 | message_number;
+      }
+    };
+
     class Samsung_AC_Device
     {
     public:
       Samsung_AC_Device(const std::string &address, MessageTarget *target)
       {
         this->address = address;
+        this->packed_address = parse_address(address);
         this->target = target;
-        this->protocol = get_protocol(address);
+        this->protocol = get_protocol(packed_address);
       }
 
       std::string address;
+      PackedAddress packed_address;
       Samsung_AC_Mode_Select *mode{nullptr};
       std::vector<Samsung_AC_Sensor> custom_sensors;
       std::vector<Samsung_AC_Custom_Switch> custom_switches;
       std::vector<Samsung_AC_Custom_Number> custom_numbers;
+      std::vector<Samsung_AC_Poll> polls;
       std::vector<Samsung_AC_CustClim*> custom_climates;
       float room_temperature_offset{0};
 
-      void getValueForCustomClimate(uint16_t address, long value);
+      // Adds a subscription for every message which is displayed by an entity of this device
+      void add_subscriptions(std::vector<Samsung_AC_Subscription> &subscriptions);
+      void publish_subscription(const Samsung_AC_Subscription &subscription, uint16_t message_number, long value);
 
 
 
@@ -120,12 +156,12 @@ namespace esphome
         custom_sensors.push_back(std::move(cust_sensor));
       }
 
-      std::set<uint16_t> get_custom_sensors()
+      void add_poll(int message_number, uint32_t interval)
       {
-        std::set<uint16_t> numbers;
-        for (auto &sensor : custom_sensors)
-          numbers.insert(sensor.message_number);
-        return numbers;
+        Samsung_AC_Poll poll;
+        poll.message_number = (uint16_t)message_number;
+        poll.interval = interval;
+        polls.push_back(poll);
       }
 
       void add_custom_switch(int message_number, Samsung_AC_Switch *switch_device)
@@ -143,14 +179,6 @@ namespace esphome
         custom_switches.push_back(std::move(cust_switch));
       }
 
-      std::set<uint16_t> get_custom_switches()
-      {
-        std::set<uint16_t> numbers;
-        for (auto &custom_switch : custom_switches)
-          numbers.insert(custom_switch.message_number);
-        return numbers;
-      }
-
       void add_custom_number(int message_number, Samsung_AC_Number *number_device, float multiply = 1.0)
       {
         Samsung_AC_Custom_Number cust_number;
@@ -167,14 +195,6 @@ namespace esphome
         custom_numbers.push_back(std::move(cust_number));
       }
 
-      std::set<uint16_t> get_custom_numbers()
-      {
-        std::set<uint16_t> numbers;
-        for (auto &custom_number : custom_numbers)
-          numbers.insert(custom_number.message_number);
-        return numbers;
-      }
-
 
 
       void set_mode_select(Samsung_AC_Mode_Select *select)
@@ -243,49 +263,9 @@ namespace esphome
 
 
 
-      void update_custom_sensor(uint16_t message_number, float value)
-      {
-        for (auto &sensor : custom_sensors)
-          if (sensor.message_number == message_number)
-          {
-            // Special handling for room temperature sensor (applies offset)
-            if (message_number == 0x4203) // VAR_in_temp_room_f
-            {
-              sensor.sensor->publish_state(value + room_temperature_offset);
-            }
-            else
-            {
-              sensor.sensor->publish_state(value);
-            }
-          }
-      }
-
-      void update_custom_switch(uint16_t message_number, bool value)
-      {
-        for (auto &custom_switch : custom_switches)
-          if (custom_switch.message_number == message_number)
-          {
-            custom_switch.switch_device->publish_state(value);
-            // Special handling for power switch (tracks state)
-            if (message_number == 0x4000) // ENUM_in_operation_power
-            {
-              _cur_power = value;
-            }
-          }
-      }
-
-      void update_custom_number(uint16_t message_number, float value)
-      {
-        for (auto &custom_number : custom_numbers)
-          if (custom_number.message_number == message_number)
-          {
-            custom_number.number_device->publish_state(value * custom_number.multiply);
-          }
-      }
-
       void publish_request(ProtocolRequest &request)
       {
-        protocol->publish_request(target, address, request);
+        protocol->publish_request(target, packed_address, request);
       }
 
       bool supports_horizontal_swing()
@@ -334,6 +314,8 @@ namespace esphome
       Protocol *protocol{nullptr};
       MessageTarget *target{nullptr};
 
+      void update_custom_climate(Samsung_AC_CustClim *cc, uint16_t address, long value);
+
       climate::ClimateSwingMode combine(climate::ClimateSwingMode climateSwingMode, uint8_t mask, bool value)
       {
         uint8_t swingMode = static_cast<uint8_t>(climateswingmode_to_swingmode(climateSwingMode));
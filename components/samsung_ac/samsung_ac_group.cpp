@@ -0,0 +1,63 @@
+#include "samsung_ac_group.h"
+#include "esphome/core/log.h"
+#include "protocol_nasa.h"
+#include "util.h"
+
+namespace esphome
+{
+  namespace samsung_ac
+  {
+    void Samsung_AC_Group::setup(const std::map<PackedAddress, Samsung_AC_Device *> &all_devices)
+    {
+      devices.clear();
+      if (addresses.empty())
+      {
+        for (const auto &pair : all_devices)
+        {
+          if (get_address_type(pair.first) == AddressType::Indoor)
+            devices.push_back(pair.second);
+        }
+      }
+
+      for (const PackedAddress address : addresses)
+      {
+        auto it = all_devices.find(address);
+        if (it == all_devices.end())
+        {
+          ESP_LOGW(TAG, "Group %s: there is no device %s", name.c_str(), address_to_string(address).c_str());
+          continue;
+        }
+        devices.push_back(it->second);
+      }
+
+      if (!broadcast_address.has_value())
+        return;
+
+      for (const auto *device : devices)
+      {
+        if (!is_nasa_address(device->packed_address))
+        {
+          ESP_LOGW(TAG, "Group %s: %s does not support broadcasts, sending to every device instead", name.c_str(), device->address.c_str());
+          broadcast_address.reset();
+          return;
+        }
+      }
+    }
+
+    void Samsung_AC_Group::publish_request(ProtocolRequest &request)
+    {
+      if (broadcast_address.has_value())
+      {
+        publish_nasa_broadcast(target, broadcast_address.value(), request);
+        return;
+      }
+
+      for (auto *device : devices)
+      {
+        // the protocols may change the request
+        ProtocolRequest copy = request;
+        device->publish_request(copy);
+      }
+    }
+  } // namespace samsung_ac
+} // namespace esphome
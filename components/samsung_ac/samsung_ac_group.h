@@ -0,0 +1,84 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+#include "protocol.h"
+#include "samsung_ac.h"
+
+namespace esphome
+{
+  namespace samsung_ac
+  {
+    // Controls several devices at once, e.g. switches all indoor units off. With a
+    // broadcast address a change is a single NASA packet which every unit picks up.
+    // Otherwise every member gets its own request, those go out back to back without
+    // waiting for the Acks in between.
+    class Samsung_AC_Group
+    {
+    public:
+      Samsung_AC_Group(const std::string &name, MessageTarget *target)
+      {
+        this->name = name;
+        this->target = target;
+      }
+
+      std::string name;
+      // resolved in setup()
+      std::vector<Samsung_AC_Device *> devices;
+
+      void add_device_address(const std::string &address)
+      {
+        addresses.push_back(parse_address(address));
+      }
+
+      void set_broadcast_address(const std::string &address)
+      {
+        broadcast_address = parse_address(address);
+      }
+
+      void set_power_switch(Samsung_AC_Switch *switch_device)
+      {
+        // Samsung_AC_Switch::write_state publishes the new state before it calls this
+        switch_device->write_state_ = [this](bool value)
+        {
+          ProtocolRequest request;
+          request.power = value;
+          publish_request(request);
+        };
+      }
+
+      void set_target_temperature_number(Samsung_AC_Number *number_device)
+      {
+        number_device->write_state_ = [this, number_device](float value)
+        {
+          number_device->publish_state(value);
+          ProtocolRequest request;
+          request.target_temp = value;
+          publish_request(request);
+        };
+      }
+
+      void set_mode_select(Samsung_AC_Mode_Select *select)
+      {
+        select->write_state_ = [this, select](Mode value)
+        {
+          select->publish_state_(value);
+          ProtocolRequest request;
+          request.mode = value;
+          publish_request(request);
+        };
+      }
+
+      // Looks up the members, all configured indoor units when none were listed.
+      void setup(const std::map<PackedAddress, Samsung_AC_Device *> &all_devices);
+
+      void publish_request(ProtocolRequest &request);
+
+    protected:
+      MessageTarget *target{nullptr};
+      std::vector<PackedAddress> addresses;
+      optional<PackedAddress> broadcast_address;
+    };
+  } // namespace samsung_ac
+} // namespace esphome
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+
+namespace esphome
+{
+    namespace samsung_ac
+    {
+        // Lock-free frame ring for exactly one producer and one consumer thread
+        // (e.g. an UART reading task and the main loop). Like FrameRing every frame
+        // is stored contiguous so it can be read in place. The producer only writes
+        // tail_, the consumer only writes head_; both are free running counters.
+        // Every frame carries a Tag with metadata (e.g. a receive timestamp).
+        // Layout per frame: 2 byte length (little endian), the tag, data.
+        template <size_t N, typename Tag = uint8_t>
+        class SpscFrameRing
+        {
+            static_assert(N >= 16 && (N & (N - 1)) == 0, "N has to be a power of two");
+
+        public:
+            // Producer side. Returns false (and counts the frame as dropped) when
+            // there is not enough room.
+            bool push(const uint8_t *data, uint16_t size, const Tag &tag = Tag())
+            {
+                const uint32_t needed = HEADER_SIZE + size;
+                if (size == 0 || size == SKIP_MARKER || needed > N)
+                {
+                    dropped_.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                }
+
+                uint32_t tail = tail_.load(std::memory_order_relaxed);
+                const uint32_t head = head_.load(std::memory_order_acquire);
+                const uint32_t index = tail & (N - 1);
+                // a frame which does not fit at the end starts at the beginning again
+                const uint32_t padding = N - index < needed ? N - index : 0;
+                if (padding + needed > N - (tail - head))
+                {
+                    dropped_.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                }
+
+                if (padding > 0)
+                {
+                    if (padding >= 2)
+                        write_size(index, SKIP_MARKER);
+                    tail += padding;
+                }
+
+                const uint32_t start = tail & (N - 1);
+                write_size(start, size);
+                std::memcpy(&buffer_[start + 2], &tag, sizeof(Tag));
+                std::memcpy(&buffer_[start + HEADER_SIZE], data, size);
+                tail_.store(tail + needed, std::memory_order_release);
+                pushed_.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+
+            // Consumer side. Returns the oldest frame or nullptr when the ring is empty.
+            const uint8_t *front(uint16_t *size, Tag *tag = nullptr)
+            {
+                uint32_t head = head_.load(std::memory_order_relaxed);
+                const uint32_t tail = tail_.load(std::memory_order_acquire);
+                if (head == tail)
+                    return nullptr;
+
+                uint32_t index = head & (N - 1);
+                if (N - index < 2 || read_size(index) == SKIP_MARKER)
+                {
+                    // the producer continued at the beginning
+                    head += N - index;
+                    head_.store(head, std::memory_order_release);
+                    index = 0;
+                }
+
+                *size = read_size(index);
+                if (tag != nullptr)
+                    std::memcpy(tag, &buffer_[index + 2], sizeof(Tag));
+                return &buffer_[index + HEADER_SIZE];
+            }
+
+            // Consumer side. Releases the frame returned by front().
+            void pop()
+            {
+                const uint32_t head = head_.load(std::memory_order_relaxed);
+                if (head == tail_.load(std::memory_order_acquire))
+                    return;
+
+                const uint32_t index = head & (N - 1);
+                head_.store(head + HEADER_SIZE + read_size(index), std::memory_order_release);
+            }
+
+            bool empty() const
+            {
+                return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+            }
+
+            uint32_t get_pushed() const { return pushed_.load(std::memory_order_relaxed); }
+            uint32_t get_dropped() const { return dropped_.load(std::memory_order_relaxed); }
+            static constexpr size_t capacity() { return N; }
+
+        protected:
+            static const uint32_t HEADER_SIZE = 2 + sizeof(Tag);
+            static const uint16_t SKIP_MARKER = 0xFFFF;
+
+            void write_size(uint32_t index, uint16_t size)
+            {
+                buffer_[index] = size & 0xFF;
+                buffer_[index + 1] = size >> 8;
+            }
+
+            uint16_t read_size(uint32_t index) const
+            {
+                return (uint16_t)buffer_[index] | (uint16_t)buffer_[index + 1] << 8;
+            }
+
+            uint8_t buffer_[N]{}; // zeroed once so reading a size is always defined
+            std::atomic<uint32_t> head_{0};
+            std::atomic<uint32_t> tail_{0};
+            std::atomic<uint32_t> pushed_{0};
+            std::atomic<uint32_t> dropped_{0};
+        };
+    } // namespace samsung_ac
+} // namespace esphome
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include "protocol.h"
+#include "ring_buffer.h"
+
+namespace esphome
+{
+    namespace samsung_ac
+    {
+        // Frames waiting to be sent, one FIFO per priority class. The highest class with a
+        // frame goes first, so user commands do not wait behind retries or polls. To keep
+        // the lower classes from starving, a frame which waited longer than the starvation
+        // limit goes first regardless of its class. Every class has its own bound (bytes
+        // and frames), a full class drops new frames without affecting the others.
+        class TxQueue
+        {
+        public:
+            static const size_t CLASSES = 3;
+            static const size_t MAX_FRAMES = 16;
+            // bytes per class, the largest frame plus its 2 byte length always fits into an empty class
+            static const size_t RING_SIZE = 2048;
+            static_assert(RING_SIZE >= MAX_PACKET_SIZE + 2, "a frame of MAX_PACKET_SIZE must fit into the ring");
+
+            void set_starvation_limit(uint32_t ms) { starvation_limit_ms_ = ms; }
+            uint32_t get_starvation_limit() const { return starvation_limit_ms_; }
+
+            bool push(TxPriority priority, const uint8_t *data, uint16_t size, uint32_t now)
+            {
+                Class &queue = classes_[(size_t)priority];
+                if (queue.frames.count() >= MAX_FRAMES || !queue.frames.push(data, size))
+                {
+                    queue.dropped++;
+                    return false;
+                }
+
+                queue.enqueued[(queue.first + queue.frames.count() - 1) % MAX_FRAMES] = now;
+                return true;
+            }
+
+            // Returns the frame to send next (priority receives its class) or nullptr.
+            const uint8_t *front(uint32_t now, uint16_t *size, TxPriority *priority) const
+            {
+                int chosen = -1;
+                for (size_t i = 0; i < CLASSES; i++)
+                {
+                    if (classes_[i].frames.empty())
+                        continue;
+                    if (chosen < 0)
+                        chosen = i;
+                    // lower classes are only preferred once they waited too long
+                    else if (age(i, now) > starvation_limit_ms_ && age(i, now) > age(chosen, now))
+                        chosen = i;
+                }
+
+                if (chosen < 0)
+                    return nullptr;
+
+                *priority = (TxPriority)chosen;
+                return classes_[chosen].frames.front(size);
+            }
+
+            // Releases the frame returned by front() once it was sent.
+            void pop(TxPriority priority, uint32_t now)
+            {
+                Class &queue = classes_[(size_t)priority];
+                if (queue.frames.empty())
+                    return;
+
+                const uint32_t waited = age((size_t)priority, now);
+                if (waited > queue.max_wait)
+                    queue.max_wait = waited;
+                queue.first = (queue.first + 1) % MAX_FRAMES;
+                queue.frames.pop();
+            }
+
+            bool empty() const
+            {
+                for (size_t i = 0; i < CLASSES; i++)
+                {
+                    if (!classes_[i].frames.empty())
+                        return false;
+                }
+                return true;
+            }
+
+            size_t depth(TxPriority priority) const { return classes_[(size_t)priority].frames.count(); }
+            uint32_t get_dropped(TxPriority priority) const { return classes_[(size_t)priority].dropped; }
+
+            // Longest wait of a frame of the class since the last call: the frames sent
+            // meanwhile and the oldest one still waiting. Starts over with every call.
+            uint32_t take_max_wait(TxPriority priority, uint32_t now)
+            {
+                Class &queue = classes_[(size_t)priority];
+                uint32_t wait = queue.max_wait;
+                if (!queue.frames.empty() && age((size_t)priority, now) > wait)
+                    wait = age((size_t)priority, now);
+                queue.max_wait = 0;
+                return wait;
+            }
+
+        protected:
+            struct Class
+            {
+                FrameRing<RING_SIZE> frames;
+                uint32_t enqueued[MAX_FRAMES]; // when the frames were queued, oldest at first
+                size_t first{0};
+                uint32_t max_wait{0};
+                uint32_t dropped{0};
+            };
+
+            // how long the oldest frame of the class waits
+            uint32_t age(size_t index, uint32_t now) const
+            {
+                return now - classes_[index].enqueued[classes_[index].first];
+            }
+
+            Class classes_[CLASSES];
+            uint32_t starvation_limit_ms_{2000};
+        };
+    } // namespace samsung_ac
+} // namespace esphome
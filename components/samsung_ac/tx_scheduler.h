@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+#include "esphome/core/helpers.h"
+
+namespace esphome
+{
+    namespace samsung_ac
+    {
+        // Decides when a queued frame may be put on the bus. The bus has no arbitration,
+        // so a frame is only sent after nothing was received for the idle gap plus a
+        // random backoff, which keeps several senders waiting for the same gap apart.
+        // After a collision the backoff window doubles (up to MAX_BACKOFF_SHIFT times)
+        // and goes back to normal after the next clean send. The min gap keeps our own
+        // frames apart so the devices have time to answer before the next one.
+        class TransmitScheduler
+        {
+        public:
+            static const uint8_t MAX_BACKOFF_SHIFT = 4;
+
+            void set_idle_gap(uint32_t ms) { idle_gap_ms_ = ms; }
+            uint32_t get_idle_gap() const { return idle_gap_ms_; }
+
+            void set_max_backoff(uint32_t ms) { max_backoff_ms_ = ms; }
+            uint32_t get_max_backoff() const { return max_backoff_ms_; }
+
+            void set_min_gap(uint32_t ms) { min_gap_ms_ = ms; }
+            uint32_t get_min_gap() const { return min_gap_ms_; }
+
+            // Called while a frame is waiting. last_rx is the time the last byte was
+            // received. A frame which has to wait because of bus traffic is counted once
+            // as deferred.
+            bool may_send(uint32_t now, uint32_t last_rx)
+            {
+                if (!waiting_)
+                {
+                    waiting_ = true;
+                    counted_deferred_ = false;
+                    const uint32_t window = max_backoff_ms_ << collisions_in_row_;
+                    backoff_ms_ = window > 0 ? random_uint32() % (window + 1) : 0;
+                }
+
+                if (now - last_rx >= idle_gap_ms_ + backoff_ms_ && now - last_sent_ >= min_gap_ms_)
+                    return true;
+
+                if (!counted_deferred_)
+                {
+                    counted_deferred_ = true;
+                    deferred_++;
+                }
+                return false;
+            }
+
+            // Called after the frame was written. collided is true when bytes of another
+            // sender were received while it was on the bus.
+            void sent(bool collided, uint32_t now)
+            {
+                waiting_ = false;
+                last_sent_ = now;
+                sent_++;
+                if (collided)
+                {
+                    collided_++;
+                    if (collisions_in_row_ < MAX_BACKOFF_SHIFT)
+                        collisions_in_row_++;
+                }
+                else
+                {
+                    collisions_in_row_ = 0;
+                }
+            }
+
+            uint32_t get_sent() const { return sent_; }
+            uint32_t get_deferred() const { return deferred_; }
+            uint32_t get_collided() const { return collided_; }
+
+        protected:
+            uint32_t idle_gap_ms_{10};
+            uint32_t max_backoff_ms_{20};
+            uint32_t min_gap_ms_{0};
+            uint32_t backoff_ms_{0};
+            uint32_t last_sent_{0};
+            uint8_t collisions_in_row_{0};
+            bool waiting_{false};
+            bool counted_deferred_{false};
+
+            uint32_t sent_{0};
+            uint32_t deferred_{0};
+            uint32_t collided_{0};
+        };
+    } // namespace samsung_ac
+} // namespace esphome
@@ -1,9 +1,29 @@
+#include "esphome/core/hal.h"
 #include "util.h"
 
 namespace esphome
 {
     namespace samsung_ac
     {
+        struct Crc16Table
+        {
+            uint16_t values[256];
+
+            constexpr Crc16Table() : values()
+            {
+                for (uint16_t i = 0; i < 256; i++)
+                {
+                    uint16_t crc = i << 8;
+                    for (uint8_t bit = 0; bit < 8; bit++)
+                        crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+                    values[i] = crc;
+                }
+            }
+        };
+
+        // Generated at compile time and kept in flash.
+        static constexpr Crc16Table crc16_table PROGMEM{};
+
         std::string long_to_hex(long number)
         {
             char str[10];
@@ -17,9 +37,14 @@ namespace esphome
         }
 
         std::string bytes_to_hex(const std::vector<uint8_t> &data)
+        {
+            return bytes_to_hex(data.data(), data.size());
+        }
+
+        std::string bytes_to_hex(const uint8_t *data, size_t size)
         {
             std::string str;
-            for (int i = 0; i < data.size(); i++)
+            for (size_t i = 0; i < size; i++)
             {
                 str += long_to_hex(data[i]);
             }
@@ -40,5 +65,17 @@ namespace esphome
         {
             std::cout << std::bitset<8>(value) << std::endl;
         }
+
+        uint16_t crc16_update(uint16_t crc, uint8_t value)
+        {
+            return (uint16_t)(crc << 8) ^ progmem_read_uint16(&crc16_table.values[(uint8_t)(crc >> 8) ^ value]);
+        }
+
+        uint16_t crc16(const uint8_t *data, size_t size, uint16_t crc)
+        {
+            for (size_t i = 0; i < size; i++)
+                crc = crc16_update(crc, data[i]);
+            return crc;
+        }
     } // namespace samsung_ac
 } // namespace esphome
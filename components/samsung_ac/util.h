@@ -16,7 +16,13 @@ namespace esphome
         std::string long_to_hex(long number);
         int hex_to_int(const std::string &hex);
         std::string bytes_to_hex(const std::vector<uint8_t> &data);
+        std::string bytes_to_hex(const uint8_t *data, size_t size);
         std::vector<uint8_t> hex_to_bytes(const std::string &hex);
         void print_bits_8(uint8_t value);
+
+        // CRC-CCITT (polynomial 0x1021, initial value 0) as used by NASA packets.
+        // crc16_update allows to calculate the checksum while bytes are received.
+        uint16_t crc16_update(uint16_t crc, uint8_t value);
+        uint16_t crc16(const uint8_t *data, size_t size, uint16_t crc = 0);
     } // namespace samsung_ac
 } // namespace esphome
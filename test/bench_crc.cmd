@@ -0,0 +1,3 @@
+@echo ==== BENCHMARK CRC ====
+@g++ -O2 test/main_bench_crc.cpp components/samsung_ac/util.cpp -Itest -o bench.exe
+@bench.exe
@@ -1,9 +1,16 @@
 #pragma once
 // Fake Hal for Local Testing
 
+#include <cstdint>
+
+#define PROGMEM
+
 namespace esphome
 {
     uint32_t millis();
     uint32_t micros();
     void delay(uint32_t ms);
+    uint8_t progmem_read_byte(const uint8_t *addr);
+    uint16_t progmem_read_uint16(const uint16_t *addr);
+    const char *progmem_read_ptr(const char *const *addr);
 } // namespace esphome
@@ -0,0 +1,93 @@
+#include <vector>
+#include <iostream>
+#include <chrono>
+#include <cassert>
+#include <cstdlib>
+#include "esphome/core/hal.h"
+
+#include "../components/samsung_ac/util.h"
+
+using namespace std;
+using namespace esphome::samsung_ac;
+
+// The former bitwise implementation, kept as reference.
+uint16_t crc16_bitwise(const uint8_t *data, size_t size)
+{
+    uint16_t crc = 0;
+    for (size_t index = 0; index < size; ++index)
+    {
+        crc = crc ^ ((uint16_t)data[index] << 8);
+        for (uint8_t i = 0; i < 8; i++)
+        {
+            if (crc & 0x8000)
+                crc = (crc << 1) ^ 0x1021;
+            else
+                crc <<= 1;
+        }
+    }
+    return crc;
+}
+
+template <typename F>
+double measure_ns_per_byte(F func, const std::vector<uint8_t> &data, int rounds)
+{
+    volatile uint16_t sink = 0;
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < rounds; i++)
+        sink = sink + func(data.data(), data.size());
+    auto end = chrono::steady_clock::now();
+    return (double)chrono::duration_cast<chrono::nanoseconds>(end - start).count() / ((double)rounds * data.size());
+}
+
+void test_same_result()
+{
+    // payload of 32001280ff00200002c013f201420101186e5434
+    auto frame = hex_to_bytes("32001280ff00200002c013f201420101186e5434");
+    assert(crc16(frame.data() + 3, frame.size() - 6) == 0x6e54);
+
+    srand(42);
+    for (int size = 0; size < 1500; size += 7)
+    {
+        std::vector<uint8_t> data(size);
+        for (auto &value : data)
+            value = rand();
+        assert(crc16(data.data(), data.size()) == crc16_bitwise(data.data(), data.size()));
+
+        // incremental calculation gives the same result
+        uint16_t crc = 0;
+        for (auto value : data)
+            crc = crc16_update(crc, value);
+        assert(crc == crc16_bitwise(data.data(), data.size()));
+    }
+}
+
+void bench()
+{
+    std::vector<uint8_t> data(1500);
+    for (auto &value : data)
+        value = rand();
+
+    const int rounds = 20000;
+    double bitwise = measure_ns_per_byte(crc16_bitwise, data, rounds);
+    double table = measure_ns_per_byte([](const uint8_t *d, size_t s)
+                                       { return crc16(d, s); },
+                                       data, rounds);
+
+    cout << "crc16 bitwise: " << bitwise << " ns/byte" << endl;
+    cout << "crc16 table:   " << table << " ns/byte" << endl;
+    cout << "speedup:       " << bitwise / table << "x" << endl;
+}
+
+namespace esphome
+{
+    uint16_t progmem_read_uint16(const uint16_t *addr)
+    {
+        return *addr;
+    }
+} // namespace esphome
+
+int main(int argc, char *argv[])
+{
+    test_same_result();
+    bench();
+};
@@ -7,26 +7,22 @@ using namespace esphome::samsung_ac;
 
 int main(int argc, char *argv[])
 {
-    debug_log_packets = true;
-
     std::ifstream file("test.txt");
     std::string str((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
 
     DebugTarget target;
-    std::vector<uint8_t> data_;
+    target.context.debug_log_packets = true;
+    Framer framer;
     for (int i = 0; i < str.size(); i += 2)
     {
         uint8_t c = hex_to_int(str.substr(i, 2));
         // cout << long_to_hex(c) << std::endl;
-        if (data_.size() == 0 && c != 0x32)
-            continue; // skip until start-byte found
-
-        data_.push_back(c);
+        if (!framer.push(c))
+            continue; // packet not complete yet
 
-        if (process_data(data_, &target) == DataResult::Clear)
+        do
         {
-            data_.clear();
-            continue; // wait for next loop
-        }
+            process_data(target.context, framer.data(), framer.size(), &target, framer.crc_checked());
+        } while (framer.next());
     }
 };
@@ -69,7 +69,7 @@ std::string GetMessageSetType(MessageSetType type)
 void process_data(std::vector<uint8_t> &data)
 {
     Packet packet;
-    if (packet.decode(data) != DecodeResult::Ok)
+    if (packet.decode(data.data(), data.size()) != DecodeResult::Ok)
         return;
 
     /*if (packet.sa.to_string() != "20.00.02" &&
@@ -85,7 +85,7 @@ void process_data(std::vector<uint8_t> &data)
 void dump_csv(std::vector<uint8_t> &data)
 {
     Packet packet;
-    if (packet.decode(data) != DecodeResult::Ok)
+    if (packet.decode(data.data(), data.size()) != DecodeResult::Ok)
         return;
 
     SYSTEMTIME time;
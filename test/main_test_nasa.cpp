@@ -1,5 +1,10 @@
+#include <cstring>
 #include "test_stuff.h"
 #include "../components/samsung_ac/protocol_nasa.h"
+#include "../components/samsung_ac/nasa_messages.h"
+#include "../components/samsung_ac/tx_scheduler.h"
+#include "../components/samsung_ac/tx_queue.h"
+#include "../components/samsung_ac/echo_checker.h"
 
 using namespace std;
 using namespace esphome::samsung_ac;
@@ -26,7 +31,7 @@ void test_nasa_2()
 {
     auto data = hex_to_bytes("32001280ff00200002c013f201420101186e5434");
     Packet packetT;
-    packetT.decode(data);
+    packetT.decode(data.data(), data.size());
     std::cout << packetT.to_string() << std::endl;
 
     Packet packet;
@@ -42,9 +47,715 @@ void test_process_data()
 {
 }
 
+void test_address_packing()
+{
+    assert(parse_address("20.00.02") == 0x200002);
+    assert(address_to_string(parse_address("20.00.02")) == "20.00.02");
+    assert(address_to_string(parse_address("c8")) == "c8");
+    assert(is_nasa_address(parse_address("10.00.00")));
+    assert(!is_nasa_address(parse_address("00")));
+    assert(get_address_type(parse_address("10.00.00")) == AddressType::Outdoor);
+    assert(get_address_type(parse_address("01")) == AddressType::Indoor);
+    assert(Address::from_packed(parse_address("80.ff.00")).to_string() == "80.ff.00");
+}
+
+void test_message_sets()
+{
+    const uint8_t payload[] = {0x01, 0x02, 0x03};
+    Packet packet = Packet::createa_partial(Address::parse("20.00.00"), DataType::Notification);
+    MessageSet structure((MessageNumber)0x4619);
+    assert(structure.type == Structure);
+    structure.structure = payload;
+    structure.structure_size = sizeof(payload);
+    packet.messages.push_back(structure);
+
+    auto data = packet.encode();
+    Packet decoded;
+    assert(decoded.decode(data.data(), data.size()) == DecodeResult::Ok);
+    assert(decoded.messages.size() == 1);
+    assert(decoded.messages[0].structure_size == sizeof(payload));
+    assert(memcmp(decoded.messages[0].structure, payload, sizeof(payload)) == 0);
+    assert(decoded.messages[0].structure >= data.data() && decoded.messages[0].structure < data.data() + data.size());
+
+    // capacity claims more messages than the packet holds
+    data = hex_to_bytes("32001280ff00200002c013f201420101186e5434");
+    data[12] = 2;
+    assert(decoded.decode(data.data(), data.size(), true) == DecodeResult::InvalidMessageSet);
+}
+
+void test_message_set_iterator()
+{
+    Packet packet = Packet::createa_partial(Address::parse("10.00.00"), DataType::Notification);
+    packet.messages.push_back(MessageSet(MessageNumber::ENUM_in_operation_power));
+    MessageSet temp(MessageNumber::VAR_in_temp_room_f);
+    temp.value = -15;
+    packet.messages.push_back(temp);
+    MessageSet energy((MessageNumber)0x8414);
+    energy.value = 123456;
+    packet.messages.push_back(energy);
+    auto data = packet.encode();
+
+    MessageSetIterator iterator(data.data(), data.size());
+    MessageSetView view;
+    assert(iterator.next(view) && view.number == 0x4000 && view.type == Enum && view.value() == 0);
+    assert(iterator.next(view) && view.number == 0x4203 && view.type == Variable && view.payload_size == 2);
+    assert(iterator.next(view) && view.number == 0x8414 && view.type == LongVariable && view.payload_size == 4);
+    assert(!iterator.next(view));
+    assert(!iterator.failed());
+
+    Packet header;
+    assert(header.decode_header(data.data(), data.size()) == DecodeResult::Ok);
+    assert(header.messages.empty());
+    assert(header.decode_messages(data.data(), data.size()) == DecodeResult::Ok);
+    assert(header.messages.size() == 3);
+    assert(header.messages[1].value == -15);
+}
+
+void test_duplicate_frames()
+{
+    DebugTarget target;
+    // off unless configured
+    assert(!target.context.duplicates.is_enabled());
+    target.context.duplicates.set_enabled(true);
+    Packet packet = Packet::createa_partial(Address::parse("10.00.00"), DataType::Notification);
+    MessageSet temp(MessageNumber::VAR_out_sensor_airout);
+    temp.value = 100;
+    packet.messages.push_back(temp);
+
+    auto process = [&](long value, uint8_t packet_number)
+    {
+        packet.messages[0].value = value;
+        packet.command.packetNumber = packet_number;
+        auto data = packet.encode();
+        process_data(target.context, data.data(), data.size(), &target);
+    };
+
+    // the packet number differs, the content does not
+    process(100, 1);
+    process(100, 2);
+    assert(target.context.duplicates.get_dropped() == 1);
+
+    // changing back to an earlier value is never dropped
+    process(101, 3);
+    process(100, 4);
+    assert(target.context.duplicates.get_dropped() == 1);
+
+    target.context.duplicates.set_enabled(false);
+    process(100, 5);
+    assert(target.context.duplicates.get_dropped() == 1);
+}
+
+void test_unconfigured_filter()
+{
+    DebugTarget target;
+    target.context.duplicates.set_enabled(false);
+    target.context.filter_unconfigured = true;
+    target.context.discovery_sample_rate = 3;
+    target.context.configured_addresses = {parse_address("20.00.00")};
+
+    auto process = [&](const std::string &source, const std::string &dest)
+    {
+        Packet packet = Packet::create(Address::parse(dest), DataType::Notification, MessageNumber::VAR_in_temp_room_f, 200);
+        packet.sa = Address::parse(source);
+        auto data = packet.encode();
+        target.last_register_address = "";
+        process_data(target.context, data.data(), data.size(), &target);
+        return target.last_register_address != "";
+    };
+
+    assert(process("20.00.00", "b0.00.ff"));  // configured source
+    assert(process("10.00.00", "20.00.00"));  // configured destination
+    assert(!process("20.00.01", "b0.00.ff")); // 1st unconfigured
+    assert(!process("20.00.01", "b0.00.ff")); // 2nd unconfigured
+    assert(process("20.00.01", "b0.00.ff"));  // 3rd is sampled
+    assert(target.context.filtered_frames == 3);
+}
+
+void test_message_registry()
+{
+    MessageInfo info;
+    assert(find_message_info(0x4001, info));
+    assert(info.type == Enum);
+    assert(info.handler == MessageHandler::OperationMode);
+
+    assert(find_message_info(0x4203, info));
+    char name[48];
+    get_message_name(info, name, sizeof(name));
+    assert(std::string(name) == "VAR_in_temp_room_f");
+    assert(get_message_value(info, 235) == 23.5);
+    assert(get_message_value(info, -15) == -1.5);
+
+    assert(find_message_info(0x8414, info));
+    assert(info.type == LongVariable);
+    assert(get_message_value(info, 12345) == 12.345);
+
+    assert(!find_message_info(0x4002 + 0x100, info));
+    assert(!find_message_info(0, info));
+    assert(!find_message_info(0xffff, info));
+}
+
+int count_frames(Framer &framer, const std::string &hex)
+{
+    int frames = 0;
+    for (uint8_t c : hex_to_bytes(hex))
+    {
+        if (!framer.push(c))
+            continue;
+        do
+        {
+            frames++;
+        } while (framer.next());
+    }
+    return frames;
+}
+
+void test_framer_resync()
+{
+    const std::string frame = "32001280ff00200002c013f201420101186e5434";
+
+    Framer framer;
+    // frame with a lost byte swallows the start of the following frame
+    assert(count_frames(framer, "32001280ff00200002c013f2014201186e5434" + frame) == 1);
+    assert(framer.empty());
+
+    // broken checksum followed by a frame with preamble
+    assert(count_frames(framer, "32001280ff00200002c013f201420101186e5534" "555555" + frame) == 1);
+    assert(framer.empty());
+
+    // stray start byte in front of a frame
+    assert(count_frames(framer, "32" + frame + frame) == 2);
+    assert(framer.empty());
+}
+
+void test_transmit_scheduler()
+{
+    TransmitScheduler scheduler;
+    scheduler.set_idle_gap(10);
+    scheduler.set_max_backoff(20);
+    esphome::random_value = 5; // backoff 5ms
+
+    // bus busy, waits for the idle gap plus backoff and is counted as deferred once
+    assert(!scheduler.may_send(1000, 995));
+    assert(!scheduler.may_send(1005, 995));
+    assert(scheduler.may_send(1010, 995));
+    scheduler.sent(false, 1010);
+    assert(scheduler.get_deferred() == 1 && scheduler.get_sent() == 1);
+
+    // quiet bus sends right away
+    assert(scheduler.may_send(2000, 1000));
+    scheduler.sent(true, 2000);
+    assert(scheduler.get_deferred() == 1 && scheduler.get_collided() == 1);
+
+    // after a collision the backoff window doubles: 45 % 41 = 4
+    esphome::random_value = 45;
+    assert(!scheduler.may_send(2013, 2000));
+    assert(scheduler.may_send(2014, 2000));
+    scheduler.sent(false, 2014);
+
+    // and is back to normal afterwards: 45 % 21 = 3
+    assert(!scheduler.may_send(3012, 3000));
+    assert(scheduler.may_send(3013, 3000));
+    scheduler.sent(false, 3013);
+    assert(scheduler.get_sent() == 4 && scheduler.get_deferred() == 3 && scheduler.get_collided() == 1);
+
+    // our own frames keep the min gap even on a quiet bus
+    scheduler.set_min_gap(100);
+    assert(!scheduler.may_send(3100, 3000));
+    assert(scheduler.may_send(3113, 3000));
+}
+
+void test_control_is_queued()
+{
+    DebugTarget target;
+    NasaProtocol protocol;
+    ProtocolRequest request;
+    request.power = true;
+    protocol.publish_request(&target, parse_address("20.00.00"), request);
+    assert(target.last_queue_data == "");
+    send_pending_nasa_requests(target.context, &target, target.context.request_settle_window);
+    assert(target.last_publish_data == "");
+    assert(target.last_queue_data.size() > 0 && target.last_queue_priority == TxPriority::Control);
+}
+
+void test_retransmit_table()
+{
+    DebugTarget target;
+    DecoderContext &context = target.context;
+    const PackedAddress indoor = parse_address("20.00.00");
+    const PackedAddress me = Address::get_my_address().to_packed();
+    context.requests.set_timeout(1000);
+    context.requests.set_max_retries(2);
+
+    Packet packet = Packet::create(Address::parse("20.00.00"), DataType::Request, MessageNumber::ENUM_in_operation_power, 1);
+    packet.command.packetNumber = 7;
+    auto frame = packet.encode();
+    assert(context.requests.add(7, parse_address("20.00.00"), frame, 0));
+
+    // the timeout starts when the frame is on the bus
+    context.requests.sent(frame.data(), frame.size(), 500);
+    check_nasa_timeouts(context, &target, 1499);
+    assert(target.last_queue_data == "");
+
+    // sent again with retry count 1 and a valid checksum
+    check_nasa_timeouts(context, &target, 1500);
+    Packet retry;
+    assert(retry.decode(hex_to_bytes(target.last_queue_data).data(), frame.size()) == DecodeResult::Ok);
+    assert(retry.command.retryCount == 1 && retry.command.packetNumber == 7);
+    assert(target.last_queue_priority == TxPriority::Retry);
+    assert(context.requests.get_retransmitted() == 1);
+
+    // every retry waits twice as long
+    auto resent = hex_to_bytes(target.last_queue_data);
+    context.requests.sent(resent.data(), resent.size(), 1500);
+    check_nasa_timeouts(context, &target, 3499);
+    assert(context.requests.get_retransmitted() == 1);
+    check_nasa_timeouts(context, &target, 3500);
+    resent = hex_to_bytes(target.last_queue_data);
+    context.requests.sent(resent.data(), resent.size(), 3500);
+    check_nasa_timeouts(context, &target, 7499);
+    assert(context.requests.get_retransmitted() == 2 && context.requests.get_failed() == 0);
+    check_nasa_timeouts(context, &target, 7500);
+    assert(context.requests.get_retransmitted() == 2 && context.requests.get_failed() == 1);
+    assert(context.requests.size() == 0);
+
+    // acknowledged requests are removed
+    assert(context.requests.add(8, parse_address("20.00.00"), frame, 0));
+    assert(!context.requests.acknowledge(9, indoor, me, 0));
+    assert(context.requests.acknowledge(8, indoor, me, 0));
+    assert(context.requests.size() == 0 && context.requests.get_acknowledged() == 1);
+
+    // an Ack to another controller with the same packet number leaves the request in flight
+    assert(context.requests.add(8, indoor, frame, 0));
+    Packet ack = Packet::createa_partial(Address::parse("62.00.00"), DataType::Ack);
+    ack.sa = Address::parse("20.00.00");
+    ack.command.packetNumber = 8;
+    auto ack_data = ack.encode();
+    process_data(context, ack_data.data(), ack_data.size(), &target);
+    assert(context.requests.size() == 1 && context.requests.get_acknowledged() == 1);
+    assert(!context.requests.acknowledge(8, parse_address("20.00.01"), me, 0));
+    ack.da = Address::get_my_address();
+    ack_data = ack.encode();
+    process_data(context, ack_data.data(), ack_data.size(), &target);
+    assert(context.requests.size() == 0 && context.requests.get_acknowledged() == 2);
+
+    // a request still waiting in the send queue is neither sent again nor failed
+    packet.command.packetNumber = 10;
+    frame = packet.encode();
+    target.last_queue_data = "";
+    assert(context.requests.add(10, parse_address("20.00.00"), frame, 10000));
+    check_nasa_timeouts(context, &target, 20000);
+    assert(target.last_queue_data == "" && context.requests.size() == 1);
+    assert(context.requests.get_retransmitted() == 2 && context.requests.get_failed() == 1);
+    context.requests.sent(frame.data(), frame.size(), 20000);
+    check_nasa_timeouts(context, &target, 21000);
+    assert(context.requests.get_retransmitted() == 3);
+    assert(context.requests.acknowledge(10, indoor, me, 21000));
+
+    // the table never grows beyond its entries
+    for (int i = 0; i < 40; i++)
+        context.requests.add(i, parse_address("20.00.00"), frame, i);
+    assert(context.requests.size() == RetransmitTable::ENTRIES);
+    assert(context.requests.get_failed() == 1 + 40 - RetransmitTable::ENTRIES);
+    assert(!context.requests.acknowledge(0, indoor, me, 40) && context.requests.acknowledge(39, indoor, me, 40));
+}
+
+void test_rtt_estimator()
+{
+    RttEstimator rtt;
+    const PackedAddress address = parse_address("20.00.00");
+    rtt.set_initial_rto(1000);
+    assert(rtt.rto(address) == 1000 && rtt.overall_srtt() == 0);
+
+    // first sample: srtt = rtt, rttvar = rtt / 2
+    rtt.sample(address, 200);
+    assert(rtt.srtt(address) == 200 && rtt.rto(address) == 200 + 4 * 100);
+
+    // srtt = 7/8 * 200 + 1/8 * 280 = 210, rttvar = 3/4 * 100 + 1/4 * 80 = 95
+    rtt.sample(address, 280);
+    assert(rtt.srtt(address) == 210 && rtt.rto(address) == 210 + 4 * 95);
+
+    // a steady round trip time converges to the lower bound
+    for (int i = 0; i < 100; i++)
+        rtt.sample(address, 50);
+    assert(rtt.srtt(address) == 50 && rtt.rto(address) == RttEstimator::MIN_RTO);
+
+    // other destinations keep their own estimate
+    assert(rtt.rto(parse_address("20.00.01")) == 1000);
+    assert(rtt.overall_srtt() == 50);
+}
+
+void test_adaptive_pacing()
+{
+    DebugTarget target;
+    DecoderContext &context = target.context;
+    const PackedAddress address = parse_address("20.00.00");
+    const PackedAddress me = Address::get_my_address().to_packed();
+    context.requests.set_timeout(1000);
+    assert(context.requests.get_pacing_gap() == 0);
+
+    Packet packet = Packet::create(Address::parse("20.00.00"), DataType::Request, MessageNumber::ENUM_in_operation_power, 1);
+    packet.command.packetNumber = 1;
+    auto frame = packet.encode();
+
+    // measured from the frame being on the bus to its Ack
+    context.requests.add(1, address, frame, 0);
+    context.requests.sent(frame.data(), frame.size(), 100);
+    assert(context.requests.acknowledge(1, address, me, 180));
+    assert(context.requests.get_rtt().srtt(address) == 80);
+    assert(context.requests.get_pacing_gap() == 40);
+
+    // the timeout follows the measurement: 80 + 4 * 40 = 240
+    packet.command.packetNumber = 2;
+    frame = packet.encode();
+    context.requests.add(2, address, frame, 1000);
+    context.requests.sent(frame.data(), frame.size(), 1000);
+    check_nasa_timeouts(context, &target, 1239);
+    assert(context.requests.get_retransmitted() == 0);
+    check_nasa_timeouts(context, &target, 1240);
+    assert(context.requests.get_retransmitted() == 1);
+
+    // a timeout doubles the gap, the Ack of a retried request is not measured
+    assert(context.requests.get_pacing_gap() == 80);
+    assert(context.requests.acknowledge(2, address, me, 1300));
+    assert(context.requests.get_rtt().srtt(address) == 80);
+    assert(context.requests.get_pacing_gap() == 80);
+
+    // a clean round trip halves it again
+    packet.command.packetNumber = 3;
+    frame = packet.encode();
+    context.requests.add(3, address, frame, 2000);
+    context.requests.sent(frame.data(), frame.size(), 2000);
+    assert(context.requests.acknowledge(3, address, me, 2080));
+    assert(context.requests.get_pacing_gap() == 40);
+}
+
+void test_coalesce_requests()
+{
+    DebugTarget target;
+    DecoderContext &context = target.context;
+    NasaProtocol protocol;
+    const PackedAddress address = parse_address("20.00.00");
+    context.request_settle_window = 100;
+
+    // a dragged slider: only the last temperature is sent, together with the power change
+    ProtocolRequest power;
+    power.power = true;
+    protocol.publish_request(&target, address, power);
+    for (int i = 0; i < 10; i++)
+    {
+        ProtocolRequest temperature;
+        temperature.target_temp = 20 + i;
+        protocol.publish_request(&target, address, temperature);
+    }
+
+    send_pending_nasa_requests(context, &target, 99);
+    assert(target.last_queue_data == "");
+    send_pending_nasa_requests(context, &target, 100);
+    assert(context.pending_requests.empty());
+    assert(context.packet_counter == 1 && context.requests.size() == 1);
+
+    Packet packet;
+    auto data = hex_to_bytes(target.last_queue_data);
+    assert(packet.decode(data.data(), data.size()) == DecodeResult::Ok);
+    assert(packet.messages.size() == 2);
+    assert(packet.messages[0].messageNumber == MessageNumber::ENUM_in_operation_power && packet.messages[0].value == 1);
+    assert(packet.messages[1].messageNumber == MessageNumber::VAR_in_temp_target_f && packet.messages[1].value == 290);
+
+    // a window of 0 sends right away
+    context.request_settle_window = 0;
+    protocol.publish_request(&target, parse_address("20.00.01"), power);
+    data = hex_to_bytes(target.last_queue_data);
+    assert(packet.decode(data.data(), data.size()) == DecodeResult::Ok);
+    assert(packet.da.to_string() == "20.00.01" && packet.command.packetNumber == 1);
+}
+
+void test_polling()
+{
+    DebugTarget target;
+    DecoderContext &context = target.context;
+    const PackedAddress indoor = parse_address("20.00.00");
+    context.polls.add(indoor, 0x4201, 1000);        // Variable
+    context.polls.add(indoor, 0x4000, 5000);        // Enum
+    context.polls.add(parse_address("20.00.01"), 0x4201, 1000);
+
+    // the first polls of the devices are spread over the interval, one Read packet per device
+    poll_nasa_messages(context, &target, 0);
+    assert(context.packet_counter == 1);
+    Packet packet;
+    auto data = hex_to_bytes(target.last_queue_data);
+    assert(packet.decode(data.data(), data.size()) == DecodeResult::Ok);
+    assert(packet.command.dataType == DataType::Read && packet.da.to_string() == "20.00.00");
+    assert(packet.messages.size() == 2);
+    assert(target.last_queue_priority == TxPriority::Poll);
+    poll_nasa_messages(context, &target, 499);
+    assert(context.packet_counter == 1);
+    poll_nasa_messages(context, &target, 500);
+    assert(context.packet_counter == 2);
+    data = hex_to_bytes(target.last_queue_data);
+    assert(packet.decode(data.data(), data.size()) == DecodeResult::Ok);
+    assert(packet.da.to_string() == "20.00.01");
+
+    // nothing due
+    poll_nasa_messages(context, &target, 999);
+    assert(context.packet_counter == 2);
+
+    // only the messages which are due are asked for
+    poll_nasa_messages(context, &target, 1500);
+    assert(context.packet_counter == 4);
+
+    // a value which arrived anyway is not asked for again
+    context.polls.seen(indoor, 0x4201, 2000);
+    poll_nasa_messages(context, &target, 2500);
+    assert(context.packet_counter == 5);
+    data = hex_to_bytes(target.last_queue_data);
+    assert(packet.decode(data.data(), data.size()) == DecodeResult::Ok);
+    assert(packet.da.to_string() == "20.00.01");
+
+    // a poll which did not fit into the send queue stays due
+    target.queue_result = false;
+    poll_nasa_messages(context, &target, 3000);
+    assert(context.packet_counter == 6);
+    poll_nasa_messages(context, &target, 3001);
+    assert(context.packet_counter == 7);
+    target.queue_result = true;
+    poll_nasa_messages(context, &target, 3002);
+    assert(context.packet_counter == 8);
+    poll_nasa_messages(context, &target, 3003);
+    assert(context.packet_counter == 8);
+
+    // many due messages are split at the frame size limit
+    DebugTarget many_target;
+    for (uint16_t i = 0; i < 100; i++)
+        many_target.context.polls.add(indoor, 0x8400 + i, 1000); // LongVariable, 6 bytes each
+    poll_nasa_messages(many_target.context, &many_target, 0);
+    assert(many_target.context.packet_counter == 3);
+    data = hex_to_bytes(many_target.last_queue_data);
+    assert(packet.decode(data.data(), data.size()) == DecodeResult::Ok);
+    assert(packet.messages.size() == 100 - 2 * ((MAX_POLL_PACKET_SIZE - 16) / 6));
+}
+
+void test_response_is_dispatched()
+{
+    // Response to a Read: 20.00.00 -> 80.ff.00 with 0x4203
+    Packet packet = Packet::create(Address::parse("80.ff.00"), DataType::Response, MessageNumber::VAR_in_temp_room_f, 245);
+    packet.sa = Address::parse("20.00.00");
+    auto data = packet.encode();
+
+    DebugTarget target;
+    process_data(target.context, data.data(), data.size(), &target);
+    assert(target.last_custom_sensors.count(0x4203) == 1);
+}
+
+void test_tx_queue()
+{
+    TxQueue queue;
+    queue.set_starvation_limit(2000);
+    const uint8_t control[] = {1}, retry[] = {2}, poll[] = {3};
+    uint16_t size;
+    TxPriority priority;
+
+    assert(queue.front(0, &size, &priority) == nullptr);
+    assert(queue.push(TxPriority::Poll, poll, 1, 0));
+    assert(queue.push(TxPriority::Retry, retry, 1, 10));
+    assert(queue.push(TxPriority::Control, control, 1, 20));
+    assert(queue.depth(TxPriority::Poll) == 1);
+
+    // highest priority first
+    assert(*queue.front(100, &size, &priority) == 1 && priority == TxPriority::Control);
+    queue.pop(priority, 100);
+    assert(queue.take_max_wait(TxPriority::Control, 100) == 80);
+    assert(queue.take_max_wait(TxPriority::Control, 100) == 0);
+    assert(*queue.front(100, &size, &priority) == 2 && priority == TxPriority::Retry);
+
+    // a poll which waited too long goes before newer control frames
+    assert(queue.push(TxPriority::Control, control, 1, 2000));
+    assert(*queue.front(2000, &size, &priority) == 1);
+    assert(*queue.front(2001, &size, &priority) == 3 && priority == TxPriority::Poll);
+    queue.pop(priority, 2001);
+    assert(queue.take_max_wait(TxPriority::Poll, 2001) == 2001);
+
+    // the wait time includes frames which still wait
+    assert(queue.take_max_wait(TxPriority::Retry, 3000) == 2990);
+
+    // every class has its own bound
+    for (size_t i = queue.depth(TxPriority::Control); i < TxQueue::MAX_FRAMES; i++)
+        assert(queue.push(TxPriority::Control, control, 1, 3000));
+    assert(!queue.push(TxPriority::Control, control, 1, 3000));
+    assert(queue.get_dropped(TxPriority::Control) == 1);
+    assert(queue.push(TxPriority::Poll, poll, 1, 3000));
+
+    // a frame of the maximum size fits
+    TxQueue large;
+    std::vector<uint8_t> frame(MAX_PACKET_SIZE, 0x55);
+    assert(large.push(TxPriority::Control, frame.data(), frame.size(), 0));
+    assert(large.front(0, &size, &priority) != nullptr && size == MAX_PACKET_SIZE);
+}
+
+void test_echo_checker()
+{
+    EchoChecker echo;
+    const auto frame = hex_to_bytes("32001180ff00200000c0130101400001c24734");
+
+    // not armed, everything goes to the framer
+    assert(!echo.pending() && !echo.feed(0x32));
+
+    // the echo is swallowed
+    echo.arm(frame.data(), frame.size());
+    assert(echo.pending());
+    for (size_t i = 0; i < frame.size(); i++)
+        assert(echo.feed(frame[i]));
+    assert(!echo.pending() && !echo.feed(0x32));
+    assert(echo.take() == EchoChecker::Result::Match);
+
+    // a differing byte is a collision, it and the following bytes are not swallowed
+    echo.arm(frame.data(), frame.size());
+    assert(echo.feed(0x32) && echo.feed(0x00));
+    assert(!echo.feed(0x55) && !echo.pending());
+    assert(!echo.feed(frame[3]));
+    assert(echo.take() == EchoChecker::Result::Mismatch);
+
+    // an incomplete echo is missing
+    echo.arm(frame.data(), frame.size());
+    assert(echo.feed(0x32));
+    assert(echo.take() == EchoChecker::Result::Missing);
+    assert(!echo.feed(0x00));
+
+    assert(echo.get_matched() == 1 && echo.get_mismatched() == 1 && echo.get_missing() == 1);
+}
+
+void test_broadcast_request()
+{
+    DebugTarget target;
+    ProtocolRequest request;
+    request.power = false;
+    publish_nasa_broadcast(&target, parse_address("b0.ff.ff"), request);
+
+    // a dragged group slider is coalesced like the requests to a device
+    for (int i = 0; i < 10; i++)
+    {
+        ProtocolRequest temperature;
+        temperature.target_temp = 20 + i;
+        publish_nasa_broadcast(&target, parse_address("b0.ff.ff"), temperature);
+    }
+    assert(target.last_queue_data == "");
+    send_pending_nasa_requests(target.context, &target, target.context.request_settle_window);
+    assert(target.context.packet_counter == 1);
+
+    Packet packet;
+    const auto data = hex_to_bytes(target.last_queue_data);
+    assert(packet.decode(data.data(), data.size()) == DecodeResult::Ok);
+    assert(packet.da.to_packed() == parse_address("b0.ff.ff") && packet.command.dataType == DataType::Request);
+    assert(packet.messages.size() == 2 && packet.messages[0].messageNumber == MessageNumber::ENUM_in_operation_power);
+    assert(packet.messages[1].value == 290);
+    assert(target.last_queue_priority == TxPriority::Control);
+
+    // nobody acknowledges it
+    assert(target.context.requests.size() == 0);
+}
+
+void test_requests_in_flight()
+{
+    DebugTarget target;
+    DecoderContext &context = target.context;
+    context.request_settle_window = 0;
+    NasaProtocol protocol;
+    ProtocolRequest request;
+    request.power = false;
+
+    for (int i = 0; i < 10; i++)
+    {
+        ProtocolRequest copy = request;
+        protocol.publish_request(&target, parse_address("20.00.0" + std::to_string(i)), copy);
+    }
+    assert(context.requests.size() == MAX_REQUESTS_IN_FLIGHT);
+    assert(context.pending_requests.size() == 10 - MAX_REQUESTS_IN_FLIGHT);
+
+    // an Ack makes room for the next one
+    send_pending_nasa_requests(context, &target, 0);
+    assert(context.pending_requests.size() == 10 - MAX_REQUESTS_IN_FLIGHT);
+    assert(context.requests.acknowledge(0, parse_address("20.00.00"), Address::get_my_address().to_packed(), 0));
+    send_pending_nasa_requests(context, &target, 0);
+    assert(context.requests.size() == MAX_REQUESTS_IN_FLIGHT && context.pending_requests.size() == 1);
+}
+
+// Queues into a real TxQueue, which is never sent.
+class QueueTarget : public DebugTarget
+{
+public:
+    TxQueue queue;
+    bool queue_data(std::vector<uint8_t> &data, TxPriority priority)
+    {
+        DebugTarget::queue_data(data, priority);
+        return queue.push(priority, data.data(), data.size(), 0);
+    }
+};
+
+void test_send_queue_full()
+{
+    QueueTarget target;
+    DecoderContext &context = target.context;
+    context.request_settle_window = 0;
+    context.requests.set_timeout(1000);
+    NasaProtocol protocol;
+    ProtocolRequest request;
+    request.power = false;
+
+    const uint8_t other[] = {1};
+    for (size_t i = 0; i < TxQueue::MAX_FRAMES; i++)
+        assert(target.queue.push(TxPriority::Control, other, 1, 0));
+
+    // requests which could not be queued do not wait for an Ack
+    for (int i = 0; i < 10; i++)
+    {
+        ProtocolRequest copy = request;
+        protocol.publish_request(&target, parse_address("20.00.0" + std::to_string(i)), copy);
+    }
+    assert(context.requests.size() == 0 && context.requests.get_failed() == 10);
+
+    // so the next one goes out once there is room
+    target.queue.pop(TxPriority::Control, 0);
+    ProtocolRequest copy = request;
+    protocol.publish_request(&target, parse_address("20.00.00"), copy);
+    assert(context.requests.size() == 1 && target.queue.depth(TxPriority::Control) == TxQueue::MAX_FRAMES);
+
+    // a retry which could not be queued counts as lost, the next one is tried after the longer timeout
+    auto frame = hex_to_bytes(target.last_queue_data);
+    context.requests.sent(frame.data(), frame.size(), 0);
+    for (size_t i = 0; i < TxQueue::MAX_FRAMES; i++)
+        assert(target.queue.push(TxPriority::Retry, other, 1, 0));
+    check_nasa_timeouts(context, &target, 1000);
+    assert(context.requests.size() == 1 && context.requests.get_retransmitted() == 1);
+    for (size_t i = 0; i < TxQueue::MAX_FRAMES; i++)
+        target.queue.pop(TxPriority::Retry, 0);
+    check_nasa_timeouts(context, &target, 2999);
+    assert(target.queue.depth(TxPriority::Retry) == 0);
+    check_nasa_timeouts(context, &target, 3000);
+    assert(target.queue.depth(TxPriority::Retry) == 1 && context.requests.get_retransmitted() == 2);
+}
+
 int main(int argc, char *argv[])
 {
     test_nasa_1();
     test_nasa_2();
     test_process_data();
+    test_framer_resync();
+    test_address_packing();
+    test_message_registry();
+    test_message_sets();
+    test_message_set_iterator();
+    test_duplicate_frames();
+    test_unconfigured_filter();
+    test_transmit_scheduler();
+    test_control_is_queued();
+    test_retransmit_table();
+    test_rtt_estimator();
+    test_adaptive_pacing();
+    test_coalesce_requests();
+    test_polling();
+    test_response_is_dispatched();
+    test_tx_queue();
+    test_echo_checker();
+    test_broadcast_request();
+    test_requests_in_flight();
+    test_send_queue_full();
 };
@@ -70,7 +70,7 @@ NonNasaDataPacket test_decode(std::string data)
 {
     NonNasaDataPacket p;
     auto bytes = hex_to_bytes(data);
-    assert(p.decode(bytes) == DecodeResult::Ok);
+    assert(p.decode(bytes.data(), bytes.size()) == DecodeResult::Ok);
     std::cout << p.to_string() << std::endl;
     return p;
 }
@@ -250,14 +250,13 @@ void test_target()
 
 void test_previous_data_is_used_correctly()
 {
-    debug_log_packets = true;
-
     // Sending package 20 on non nasa requiers to send the previous values
     // these values need to be stored for each address. This test makes sure
     // this process works.
     std::cout << "test_previous_data_is_used_correctly" << std::endl;
 
     DebugTarget target;
+    target.context.debug_log_packets = true;
 
     // Test1
 
@@ -266,8 +265,9 @@ void test_previous_data_is_used_correctly()
 
     ProtocolRequest req1;
     req1.power = false;
-    get_protocol("00")->publish_request(&target, "00", req1);
+    get_protocol(parse_address("00"))->publish_request(&target, parse_address("00"), req1);
     test_process_data("32c8f0f80345f0c913000000ac34", target); // trigger publish
+    send_non_nasa_requests(target.context, &target, NON_NASA_SEND_DELAY);
 
     NonNasaRequest request1;
     request1.dst = "00";
@@ -285,8 +285,9 @@ void test_previous_data_is_used_correctly()
 
     ProtocolRequest req2;
     req2.power = true;
-    get_protocol("01")->publish_request(&target, "01", req2);
+    get_protocol(parse_address("01"))->publish_request(&target, parse_address("01"), req2);
     test_process_data("32c8f0f80345f0c913000000ac34", target); // trigger publish
+    send_non_nasa_requests(target.context, &target, NON_NASA_SEND_DELAY);
 
     NonNasaRequest request2;
     request2.dst = "01";
@@ -298,6 +299,55 @@ void test_previous_data_is_used_correctly()
     assert_str(bytes_to_hex(request2.encode()), target.last_publish_data);
 }
 
+void test_send_window()
+{
+    DebugTarget target;
+    test_process_data("3200c8204d51500001100051e434", target);
+
+    ProtocolRequest request;
+    request.power = true;
+    get_protocol(parse_address("00"))->publish_request(&target, parse_address("00"), request);
+    get_protocol(parse_address("00"))->publish_request(&target, parse_address("00"), request);
+
+    // nothing is sent without a trigger frame
+    send_non_nasa_requests(target.context, &target, NON_NASA_SEND_DELAY);
+    assert(target.last_publish_data == "");
+
+    // the first request goes out after the delay, not while the trigger frame is processed
+    test_process_data("32c8f0f80345f0c913000000ac34", target);
+    assert(target.last_publish_data == "");
+    send_non_nasa_requests(target.context, &target, NON_NASA_SEND_DELAY - 1);
+    assert(target.last_publish_data == "");
+    send_non_nasa_requests(target.context, &target, NON_NASA_SEND_DELAY);
+    assert(target.last_publish_data != "" && target.context.nonnasa_requests.size() == 1);
+
+    // the second one waits for the next window once this one closed
+    target.last_publish_data = "";
+    send_non_nasa_requests(target.context, &target, NON_NASA_WINDOW_CLOSE);
+    assert(target.last_publish_data == "" && !target.context.nonnasa_window_open);
+    send_non_nasa_requests(target.context, &target, NON_NASA_WINDOW_CLOSE + NON_NASA_SEND_DELAY);
+    assert(target.last_publish_data == "" && target.context.nonnasa_requests.size() == 1);
+}
+
+void test_collided_request_is_sent_again()
+{
+    DebugTarget target;
+    test_process_data("3200c8204d51500001100051e434", target);
+
+    ProtocolRequest request;
+    request.power = true;
+    get_protocol(parse_address("00"))->publish_request(&target, parse_address("00"), request);
+
+    test_process_data("32c8f0f80345f0c913000000ac34", target);
+    target.publish_result = false;
+    send_non_nasa_requests(target.context, &target, NON_NASA_SEND_DELAY);
+    assert(target.last_publish_data != "" && target.context.nonnasa_requests.size() == 1);
+
+    target.publish_result = true;
+    send_non_nasa_requests(target.context, &target, 2 * NON_NASA_SEND_DELAY);
+    assert(target.context.nonnasa_requests.size() == 0);
+}
+
 int main(int argc, char *argv[])
 {
     // test_read_file();
@@ -306,4 +356,6 @@ int main(int argc, char *argv[])
     test_target();
 
     test_previous_data_is_used_correctly();
+    test_send_window();
+    test_collided_request_is_sent_again();
 };
@@ -0,0 +1,109 @@
+#include <vector>
+#include <iostream>
+#include <thread>
+#include <cassert>
+
+#include "../components/samsung_ac/spsc_ring.h"
+
+using namespace std;
+using namespace esphome::samsung_ac;
+
+// Every frame carries its sequence number in the first 4 bytes, the rest is derived from it.
+uint16_t frame_size(uint32_t sequence)
+{
+    return 4 + (sequence * 7919) % 600;
+}
+
+void fill_frame(uint32_t sequence, vector<uint8_t> &frame)
+{
+    frame.resize(frame_size(sequence));
+    frame[0] = sequence & 0xFF;
+    frame[1] = (sequence >> 8) & 0xFF;
+    frame[2] = (sequence >> 16) & 0xFF;
+    frame[3] = (sequence >> 24) & 0xFF;
+    for (size_t i = 4; i < frame.size(); i++)
+        frame[i] = (uint8_t)(sequence + i);
+}
+
+void test_single_thread()
+{
+    SpscFrameRing<64> ring;
+    uint16_t size;
+    uint8_t tag;
+    const uint8_t frame[] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+
+    assert(ring.front(&size) == nullptr);
+    // wraps around several times
+    for (int i = 0; i < 100; i++)
+    {
+        assert(ring.push(frame, sizeof(frame), i));
+        assert(ring.push(frame, 5 + i % 5));
+        assert(ring.front(&size, &tag) != nullptr && size == sizeof(frame) && tag == (uint8_t)i);
+        ring.pop();
+        assert(ring.front(&size, &tag) != nullptr && size == 5 + i % 5 && tag == 0);
+        ring.pop();
+        assert(ring.empty());
+    }
+
+    // full
+    while (ring.push(frame, sizeof(frame)))
+        ;
+    assert(ring.get_dropped() == 1);
+    assert(!ring.push(frame, 100)); // larger than the ring
+    assert(ring.get_dropped() == 2);
+}
+
+void test_threads()
+{
+    static SpscFrameRing<4096> ring;
+    const uint32_t frames = 200000;
+
+    thread producer([&]()
+                    {
+        vector<uint8_t> frame;
+        for (uint32_t sequence = 0; sequence < frames; sequence++)
+        {
+            fill_frame(sequence, frame);
+            if (!ring.push(frame.data(), frame.size(), sequence & 0xFF))
+                this_thread::yield();
+        } });
+
+    uint32_t received = 0;
+    int64_t last = -1;
+    vector<uint8_t> expected;
+    while (last < (int64_t)frames - 1)
+    {
+        uint16_t size;
+        uint8_t tag;
+        const uint8_t *data = ring.front(&size, &tag);
+        if (data == nullptr)
+        {
+            if (received + ring.get_dropped() == frames)
+                break;
+            this_thread::yield();
+            continue;
+        }
+
+        const uint32_t sequence = data[0] | data[1] << 8 | data[2] << 16 | (uint32_t)data[3] << 24;
+        assert((int64_t)sequence > last);
+        assert(tag == (sequence & 0xFF));
+        fill_frame(sequence, expected);
+        assert(size == expected.size());
+        assert(equal(expected.begin(), expected.end(), data));
+        last = sequence;
+        received++;
+        ring.pop();
+    }
+
+    producer.join();
+    assert(ring.empty());
+    assert(received == ring.get_pushed());
+    assert(received + ring.get_dropped() == frames);
+    cout << "spsc: received " << received << " dropped " << ring.get_dropped() << endl;
+}
+
+int main()
+{
+    test_single_thread();
+    test_threads();
+};
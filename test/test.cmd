@@ -1,3 +1,5 @@
 @call "%~dp0%test_nasa.cmd"
 
 @call "%~dp0%test_non_nasa.cmd"
+
+@call "%~dp0%test_spsc.cmd"
@@ -1,3 +1,4 @@
 #/bin/sh
 ./test/test_nasa.sh
-./test/test_non_nasa.sh
\ No newline at end of file
+./test/test_non_nasa.sh
+./test/test_spsc.sh
\ No newline at end of file
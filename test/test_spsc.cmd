@@ -0,0 +1,3 @@
+@echo ==== TESTING SPSC RING ====
+@g++ -O2 -pthread test/main_test_spsc.cpp -Itest -o spsc.exe
+@spsc.exe
\ No newline at end of file
@@ -0,0 +1,4 @@
+echo ==== TESTING SPSC RING ====
+g++ -O2 -pthread test/main_test_spsc.cpp -Itest -o spsc.exe
+chmod +x spsc.exe
+./spsc.exe
\ No newline at end of file
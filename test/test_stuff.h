@@ -7,6 +7,7 @@
 
 #include "../components/samsung_ac/util.h"
 #include "../components/samsung_ac/protocol.h"
+#include "../components/samsung_ac/decoder_context.h"
 
 using namespace std;
 using namespace esphome::samsung_ac;
@@ -19,16 +20,41 @@ public:
         return 0;
     }
 
+    uint32_t get_frame_received_miliseconds()
+    {
+        return 0;
+    }
+
+    DecoderContext context;
+    DecoderContext &get_decoder_context()
+    {
+        return context;
+    }
+
     std::string last_publish_data;
-    void publish_data(std::vector<uint8_t> &data)
+    bool publish_result = true;
+    bool publish_data(std::vector<uint8_t> &data)
     {
         last_publish_data = bytes_to_hex(data);
         cout << "> publish_data " << last_publish_data << endl;
+        return publish_result;
+    }
+
+    std::string last_queue_data;
+    TxPriority last_queue_priority;
+    bool queue_result = true;
+    bool queue_data(std::vector<uint8_t> &data, TxPriority priority)
+    {
+        last_queue_data = bytes_to_hex(data);
+        last_queue_priority = priority;
+        cout << "> queue_data " << last_queue_data << endl;
+        return queue_result;
     }
 
     std::string last_register_address;
-    void register_address(const std::string address)
+    void register_address(PackedAddress packed)
     {
+        const std::string address = address_to_string(packed);
         cout << "> register_address " << address << endl;
         last_register_address = address;
     }
@@ -89,8 +115,9 @@ public:
 
     std::string last_set_mode_address;
     Mode last_set_mode_mode;
-    void set_mode(const std::string address, Mode mode)
+    void set_mode(PackedAddress packed, Mode mode)
     {
+        const std::string address = address_to_string(packed);
         cout << "> " << address << " set_mode=" << to_string((int)mode) << endl;
         last_set_mode_address = address;
         last_set_mode_mode = mode;
@@ -122,14 +149,14 @@ public:
 
     std::set<uint16_t> last_custom_sensors;
 
-    esphome::optional<std::set<uint16_t>> get_custom_sensors(const std::string address)
+    void dispatch_message(PackedAddress address, uint16_t message_number, long value)
     {
-        return last_custom_sensors;
+        last_custom_sensors.insert(message_number);
     }
 
-    void set_custom_sensor(const std::string address, uint16_t message_number, float value)
+    bool is_subscribed(PackedAddress address, uint16_t message_number)
     {
-        last_custom_sensors.insert(message_number);
+        return true;
     }
 
     void assert_only_address(const std::string address)
@@ -175,7 +202,7 @@ void test_process_data(const std::string &hex, DebugTarget &target)
 {
     cout << "test: " << hex << std::endl;
     auto bytes = hex_to_bytes(hex);
-    assert(process_data(bytes, &target) == DataResult::Clear);
+    assert(process_data(target.context, bytes.data(), bytes.size(), &target) == DataResult::Clear);
 }
 
 DebugTarget test_process_data(const std::string &hex)
@@ -206,4 +233,22 @@ namespace esphome
         return 0;
     }
     void delay(uint32_t ms) {}
+    uint8_t progmem_read_byte(const uint8_t *addr)
+    {
+        return *addr;
+    }
+    uint16_t progmem_read_uint16(const uint16_t *addr)
+    {
+        return *addr;
+    }
+    const char *progmem_read_ptr(const char *const *addr)
+    {
+        return *addr;
+    }
+    // deterministic, tests can predict the backoff
+    uint32_t random_value = 0;
+    uint32_t random_uint32()
+    {
+        return random_value;
+    }
 } // namespace esphome